@@ -0,0 +1,21 @@
+#!/bin/bash
+# Compares the spatial indices on uniform and clustered instances
+
+mkdir -p ../bench
+for n in 50000 1000000
+do
+  [ -f ../bench/uniform-$n.instance.json ] || ./gen.py uniform $n 300 ../bench/uniform-$n.instance.json
+  [ -f ../bench/clustered-$n.instance.json ] || ./gen.py clustered $n 300 ../bench/clustered-$n.instance.json
+done
+
+g++ main.cpp -std=c++20 -Wfatal-errors -pthread -o main -Ofast
+
+TIMEFORMAT=%Rs
+for f in `ls -Sr ../bench/*.json ../input/*.json`
+do
+  for index in grid kd auto
+  do
+    echo -n $f" "$index" "
+    time ./main $f ${f%.instance.json}.solution.svg --others=0 --index=$index > /dev/null
+  done
+done
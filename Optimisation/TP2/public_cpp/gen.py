@@ -0,0 +1,61 @@
+#!/usr/bin/python3
+# Generates TP2 benchmark instances
+#   ./gen.py uniform n radius output.instance.json
+#   ./gen.py clustered n radius output.instance.json [clusters]
+#   ./gen.py mixed n radius output.instance.json [spread]
+
+import sys
+import json
+import random
+
+
+def uniform(n, size):
+  return [(random.randrange(size), random.randrange(size)) for _ in range(n)]
+
+
+# Gaussian blobs of very different sizes, like city lights
+def clustered(n, size, clusters):
+  centers = [(random.randrange(size), random.randrange(size),
+              size * random.choice([0.0005, 0.002, 0.01, 0.05]))
+             for _ in range(clusters)]
+  pts = []
+  while len(pts) < n:
+    cx, cy, sigma = random.choice(centers)
+    x, y = int(random.gauss(cx, sigma)), int(random.gauss(cy, sigma))
+    if 0 <= x < size and 0 <= y < size:
+      pts.append((x, y))
+  return pts
+
+
+# Per-point radii, log-uniform within a factor 2^spread of radius
+def radii(n, radius, spread):
+  return [max(1, round(radius * 2 ** random.uniform(-spread, spread))) for _ in range(n)]
+
+
+def main():
+  if len(sys.argv) < 5:
+    print("./gen.py uniform|clustered|mixed n radius output.instance.json [clusters|spread]")
+    exit(1)
+  kind, n, radius, fn = sys.argv[1], int(sys.argv[2]), int(sys.argv[3]), sys.argv[4]
+  random.seed(n)
+  size = 1 << 20
+  points = []
+  if kind == "uniform":
+    pts = uniform(n, size)
+  elif kind == "mixed":
+    spread = float(sys.argv[5]) if len(sys.argv) > 5 else 3
+    pts = uniform(n, size)
+    points = [{"i": i, "x": float(x), "y": float(y), "r": r}
+              for i, ((x, y), r) in enumerate(zip(pts, radii(n, radius, spread)))]
+  else:
+    clusters = int(sys.argv[5]) if len(sys.argv) > 5 else 100
+    pts = clustered(n, size, clusters)
+
+  if not points:
+    points = [{"i": i, "x": float(x), "y": float(y)} for i, (x, y) in enumerate(pts)]
+  with open(fn, "w") as f:
+    json.dump({"radius": radius, "points": points}, f)
+
+
+if __name__ == '__main__':
+  main()
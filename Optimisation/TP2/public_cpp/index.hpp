@@ -0,0 +1,454 @@
+// BERTOLINI Garice
+#ifndef INDEX_HPP
+#define INDEX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "point.hpp"
+
+// Spatial indices answering "all points within 2 * radius of pts[i]"
+// (within ri + rj for the per-point radii of MultiGridIndex).
+// They share the same interface:
+//   forEachNear(i, f) calls f(j) for every j (i included) overlapping i
+// GridIndex and KdIndex also take a smaller squared diameter,
+//   forEachNear(i, d2, f), to answer a smaller radius from the same index.
+
+using Cell = Point<long long>;
+
+struct CellHash {
+    size_t operator()(const Cell& c) const noexcept {
+        // std::hash<long long> is the identity, so h1 ^ (h2 << 1) sent
+        // whole regions of the map to a few buckets. Multiply-xorshift mix.
+        uint64_t h = (uint64_t)c.x * 0x9E3779B97F4A7C15ull ^ (uint64_t)c.y;
+        h ^= h >> 32;
+        h *= 0xD6E8FEB86659FD93ull;
+        h ^= h >> 32;
+        return h;
+    }
+};
+
+// Build cell key with floor to handle negatives
+template <class Number>
+Cell key_of(const Point<Number> &p, double cellSize)
+{
+    long double L = static_cast<long double>(cellSize);
+    long double fx = std::floor(static_cast<long double>(p.x) / L);
+    long double fy = std::floor(static_cast<long double>(p.y) / L);
+    return {static_cast<long long>(fx), static_cast<long long>(fy)};
+}
+
+// Uniform grid of 2 * radius cells, neighbours are in the 3x3 block around
+template <class Number>
+class GridIndex
+{
+    using Wide = typename Arithmetic<Number>::Wide;
+
+    const std::vector<Point<Number>> &pts;
+    double cellSize;
+    Wide dist_max2;
+    std::unordered_map<Cell, std::vector<int>, CellHash> grid;
+
+public:
+    GridIndex(const std::vector<Point<Number>> &_pts, double radius, Wide _dist_max2) :
+        pts(_pts),
+        cellSize(2 * radius),
+        dist_max2(_dist_max2)
+    {
+        // Match each point with a cell on a grid
+        int ptsSize = (int) pts.size();
+        for (int i = 0; i < ptsSize; ++i) {
+            grid[key_of(pts[i], cellSize)].push_back(i);
+        }
+    }
+
+    template <class F>
+    void forEachNear(int ip, F &&f) const
+    {
+        forEachNear(ip, dist_max2, f);
+    }
+
+    template <class F>
+    void forEachNear(int ip, Wide d2, F &&f) const
+    {
+        const auto &p = pts[ip]; // Fetch p
+
+        // Get cell_x and cell_y which is p / cellSize
+        auto [cx, cy] = key_of(p, cellSize);
+
+        // Search around the target cell with a delta betwen -1 and 1
+        for (long long dx = -1; dx <= 1; ++dx)
+            for (long long dy = -1; dy <= 1; ++dy)
+            {
+                auto it = grid.find({cx + dx, cy + dy}); //! O(1)
+                if (it == grid.end())
+                    continue;
+
+                // Squared distance for efficiency
+                for (int j : it->second)
+                    if (p.distance2(pts[j]) <= d2)
+                        f(j);
+            }
+    }
+};
+
+// Bucketed k-d tree, split at the median of the longest side until a leaf
+// holds at most leafSize points. Only nodes whose box is within 2 * radius
+// are visited, so dense clusters cost the points really near, not the cell.
+template <class Number>
+class KdIndex
+{
+    using Wide = typename Arithmetic<Number>::Wide;
+
+    struct Node
+    {
+        Number minx, miny, maxx, maxy;
+        int begin, end; // Range in order / sorted
+        int left;       // Children are left and left + 1, -1 for a leaf
+    };
+
+    const std::vector<Point<Number>> &pts;
+    Wide dist_max2;
+    std::vector<Node> nodes;
+    std::vector<int> order;              // Point indices in leaf order
+    std::vector<Point<Number>> sorted;   // Copy of pts in leaf order
+
+public:
+    KdIndex(const std::vector<Point<Number>> &_pts, Wide _dist_max2, int leafSize = 16) :
+        pts(_pts),
+        dist_max2(_dist_max2),
+        order(pts.size())
+    {
+        std::iota(order.begin(), order.end(), 0);
+        if (pts.empty())
+            return;
+
+        nodes.reserve(2 * pts.size() / leafSize + 2);
+        nodes.push_back(Node{0, 0, 0, 0, 0, (int) pts.size(), -1});
+
+        // Nodes are split in creation order, so no recursion is needed
+        for (std::size_t k = 0; k < nodes.size(); ++k)
+        {
+            int begin = nodes[k].begin, end = nodes[k].end;
+
+            Number minx = pts[order[begin]].x, maxx = minx;
+            Number miny = pts[order[begin]].y, maxy = miny;
+            for (int i = begin; i < end; ++i)
+            {
+                const auto &p = pts[order[i]];
+                minx = std::min(minx, p.x);
+                maxx = std::max(maxx, p.x);
+                miny = std::min(miny, p.y);
+                maxy = std::max(maxy, p.y);
+            }
+            nodes[k].minx = minx;
+            nodes[k].miny = miny;
+            nodes[k].maxx = maxx;
+            nodes[k].maxy = maxy;
+
+            if (end - begin <= leafSize)
+                continue;
+
+            bool alongX = Wide(maxx) - Wide(minx) >= Wide(maxy) - Wide(miny);
+            int mid = begin + (end - begin) / 2;
+            std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                [&](int i, int j) {
+                    return alongX ? pts[i].x < pts[j].x : pts[i].y < pts[j].y;
+                });
+
+            nodes[k].left = (int) nodes.size();
+            nodes.push_back(Node{0, 0, 0, 0, begin, mid, -1});
+            nodes.push_back(Node{0, 0, 0, 0, mid, end, -1});
+        }
+
+        sorted.reserve(pts.size());
+        for (int i : order)
+            sorted.push_back(pts[i]);
+    }
+
+    template <class F>
+    void forEachNear(int ip, F &&f) const
+    {
+        forEachNear(ip, dist_max2, f);
+    }
+
+    template <class F>
+    void forEachNear(int ip, Wide d2, F &&f) const
+    {
+        const auto &p = pts[ip];
+        int stack[64];
+        int top = 0;
+        if (!nodes.empty())
+            stack[top++] = 0;
+
+        while (top > 0)
+        {
+            const Node &node = nodes[stack[--top]];
+
+            // Squared distance from p to the box of the node
+            Wide dx = std::max<Wide>({Wide(node.minx) - Wide(p.x), Wide(p.x) - Wide(node.maxx), 0});
+            Wide dy = std::max<Wide>({Wide(node.miny) - Wide(p.y), Wide(p.y) - Wide(node.maxy), 0});
+            if (dx * dx + dy * dy > d2)
+                continue;
+
+            if (node.left < 0)
+            {
+                for (int k = node.begin; k < node.end; ++k)
+                    if (p.distance2(sorted[k]) <= d2)
+                        f(order[k]);
+            }
+            else
+            {
+                stack[top++] = node.left;
+                stack[top++] = node.left + 1;
+            }
+        }
+    }
+};
+
+// Disks of different radii, overlapping when dist2 <= (ri + rj)^2.
+// One grid per radius class: a disk of radius r goes to the level of the
+// radii in [2^k, 2^(k+1)), whose cells are twice its biggest radius. A
+// query scans, on each level, the cells within ri + that biggest radius,
+// so small disks never pay for a cell sized by the biggest disk.
+// Points of a level are copied in (row, column) cell order, so each row of
+// the block around a query is one contiguous range: read from a dense table
+// when the box of the level has few enough cells, otherwise found by binary
+// search among the cells of that row.
+template <class Number>
+class MultiGridIndex
+{
+    struct Level
+    {
+        double maxRadius = 0;
+        double cellSize = 0;
+        Cell low{0, 0};             // Smallest cell of the level
+        long long nx = 0, ny = 0;   // Cells of its box, 0 when sparse
+        std::vector<int> start;     // Dense: first point of each cell
+
+        // Sparse: non-empty cells in order, with their first point, and
+        // the range of each row among them
+        std::vector<long long> columns;
+        std::vector<int> cellStart;
+        std::unordered_map<long long, std::pair<int, int>> rows;
+        std::vector<int> order;              // Point indices in cell order
+        std::vector<Point<Number>> sorted;   // Copies in cell order
+        std::vector<double> sortedRadii;
+    };
+
+    const std::vector<Point<Number>> &pts;
+    const std::vector<double> &radii;
+    std::vector<Level> levels;
+
+    // Radius classes, radius 0 shares the class of the smallest disks
+    static int classOf(double r, double minRadius)
+    {
+        return std::ilogb(std::max(r, minRadius));
+    }
+
+    template <class F>
+    void scan(const Level &level, int begin, int end, int ip, F &f) const
+    {
+        const auto &p = pts[ip];
+        for (int k = begin; k < end; ++k)
+        {
+            long double reach = (long double)radii[ip] + level.sortedRadii[k];
+            if ((long double)p.distance2(level.sorted[k]) <= reach * reach)
+                f(level.order[k]);
+        }
+    }
+
+    void build(Level &level)
+    {
+        std::vector<Cell> keys;
+        keys.reserve(level.order.size());
+        for (int i : level.order)
+            keys.push_back(key_of(pts[i], level.cellSize));
+
+        std::vector<int> perm(level.order.size());
+        std::iota(perm.begin(), perm.end(), 0);
+        std::sort(perm.begin(), perm.end(), [&](int a, int b) {
+            return std::tie(keys[a].y, keys[a].x) < std::tie(keys[b].y, keys[b].x);
+        });
+
+        std::vector<int> order;
+        order.reserve(perm.size());
+        for (int a : perm)
+        {
+            order.push_back(level.order[a]);
+            level.sorted.push_back(pts[level.order[a]]);
+            level.sortedRadii.push_back(radii[level.order[a]]);
+        }
+        level.order = std::move(order);
+
+        long long x0 = keys[0].x, x1 = x0, y0 = keys[0].y, y1 = y0;
+        for (const Cell &c : keys)
+        {
+            x0 = std::min(x0, c.x);
+            x1 = std::max(x1, c.x);
+            y0 = std::min(y0, c.y);
+            y1 = std::max(y1, c.y);
+        }
+
+        // Dense table when it costs at most 16 ints per point
+        long long limit = 16 * (long long) keys.size() + 65536;
+        long long nx = x1 - x0 + 1, ny = y1 - y0 + 1;
+        if (nx <= limit && ny <= limit && nx * ny <= limit)
+        {
+            level.low = {x0, y0};
+            level.nx = nx;
+            level.ny = ny;
+            level.start.assign(nx * ny + 1, 0);
+            for (const Cell &c : keys)
+                level.start[(c.y - y0) * nx + (c.x - x0) + 1]++;
+            for (long long k = 0; k < nx * ny; ++k)
+                level.start[k + 1] += level.start[k];
+            return;
+        }
+
+        for (int k = 0; k < (int) perm.size(); ++k)
+        {
+            const Cell &c = keys[perm[k]];
+            if (k > 0 && c == keys[perm[k - 1]])
+                continue;
+            int cell = (int) level.columns.size();
+            level.columns.push_back(c.x);
+            level.cellStart.push_back(k);
+            level.rows.try_emplace(c.y, cell, cell).first->second.second = cell + 1;
+        }
+        level.cellStart.push_back((int) perm.size());
+    }
+
+public:
+    MultiGridIndex(const std::vector<Point<Number>> &_pts, const std::vector<double> &_radii) :
+        pts(_pts),
+        radii(_radii)
+    {
+        double minRadius = INFINITY;
+        for (double r : radii)
+            if (r > 0)
+                minRadius = std::min(minRadius, r);
+        if (minRadius == INFINITY) // Only points, any cell size works
+            minRadius = 0.5;
+
+        // Class -> level, by increasing radius
+        std::map<int, int> classes;
+        for (double r : radii)
+            classes[classOf(r, minRadius)] = 0;
+        for (auto &[k, level] : classes)
+        {
+            level = (int) levels.size();
+            levels.emplace_back();
+        }
+
+        int ptsSize = (int) pts.size();
+        for (int i = 0; i < ptsSize; ++i)
+        {
+            Level &level = levels[classes[classOf(radii[i], minRadius)]];
+            level.maxRadius = std::max(level.maxRadius, radii[i]);
+            level.order.push_back(i);
+        }
+        for (Level &level : levels)
+        {
+            level.cellSize = 2 * std::max(level.maxRadius, minRadius);
+            build(level);
+        }
+    }
+
+    std::size_t levelCount() const { return levels.size(); }
+
+    template <class F>
+    void forEachNear(int ip, F &&f) const
+    {
+        const auto &p = pts[ip];
+        for (const Level &level : levels)
+        {
+            double reach = radii[ip] + level.maxRadius;
+            long long span = (long long) std::ceil(reach / level.cellSize);
+            auto [cx, cy] = key_of(p, level.cellSize);
+
+            if (level.nx > 0)
+            {
+                // Rows of the block, clipped to the box of the level
+                long long xa = std::max(cx - span - level.low.x, 0LL);
+                long long xb = std::min(cx + span - level.low.x, level.nx - 1);
+                long long ya = std::max(cy - span - level.low.y, 0LL);
+                long long yb = std::min(cy + span - level.low.y, level.ny - 1);
+                for (long long y = ya; xa <= xb && y <= yb; ++y)
+                    scan(level, level.start[y * level.nx + xa],
+                         level.start[y * level.nx + xb + 1], ip, f);
+            }
+            else
+            {
+                for (long long y = cy - span; y <= cy + span; ++y)
+                {
+                    auto it = level.rows.find(y);
+                    if (it == level.rows.end())
+                        continue;
+                    auto first = level.columns.begin() + it->second.first;
+                    auto last = level.columns.begin() + it->second.second;
+                    int a = (int) (std::lower_bound(first, last, cx - span) - level.columns.begin());
+                    int b = (int) (std::upper_bound(first, last, cx + span) - level.columns.begin());
+                    scan(level, level.cellStart[a], level.cellStart[b], ip, f);
+                }
+            }
+        }
+    }
+};
+
+enum class IndexKind
+{
+    Auto,
+    Grid,
+    KdTree
+};
+
+// Estimates how many points a grid query scans on average, from a quick
+// density histogram counting a sample of the points per 2 * radius cell
+template <class Number>
+double estimateScanned(const std::vector<Point<Number>> &pts, double radius)
+{
+    const std::size_t n = pts.size();
+    const std::size_t stride = std::max<std::size_t>(1, n / 65536);
+    const double f = 1.0 / stride; // Sampling rate
+
+    std::unordered_map<Cell, int, CellHash> histogram;
+    std::size_t sampled = 0;
+    for (std::size_t i = 0; i < n; i += stride, ++sampled)
+        histogram[key_of(pts[i], 2 * radius)]++;
+    if (sampled == 0)
+        return 0;
+
+    // A cell of N points holds c ~ Binomial(N, f) samples,
+    // so E[c²] = f² N² + f (1 - f) N gives back the sum of N²
+    double sumC2 = 0;
+    for (const auto &[cell, c] : histogram)
+        sumC2 += (double)c * c;
+    double sumN2 = (sumC2 - (1 - f) * sampled) / (f * f);
+
+    // Points in the 3x3 block around a point, assuming similar neighbours
+    return 9 * sumN2 / n;
+}
+
+// Picks the index from the estimated scans. The k-d tree pays off when
+// those scans are long, i.e. when the points are clustered, and on big
+// instances where the random accesses of the grid miss the cache.
+template <class Number>
+IndexKind chooseIndex(const std::vector<Point<Number>> &pts, double radius)
+{
+    const std::size_t n = pts.size();
+    double scanned = estimateScanned(pts, radius);
+
+    // Measured with bench.sh, the grid is never faster beyond these
+    const double kdScanned = 128;
+    const std::size_t kdPoints = 1 << 17;
+    return scanned > kdScanned || n > kdPoints ? IndexKind::KdTree : IndexKind::Grid;
+}
+
+#endif
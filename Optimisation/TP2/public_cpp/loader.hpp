@@ -0,0 +1,380 @@
+// BERTOLINI Garice
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "rapidjson/document.h"
+#include "rapidjson/filereadstream.h"
+#include "rapidjson/istreamwrapper.h"
+#include "rapidjson/reader.h"
+
+// Raw content of an instance file, coordinates kept as parsed doubles
+struct Instance
+{
+    std::vector<double> x, y;
+    double radius = 0;
+    std::vector<double> r; // Per-point radii, empty when all disks have radius
+
+    std::size_t size() const { return x.size(); }
+};
+
+[[noreturn]] inline void loadError(const std::string &fn, const std::string &what)
+{
+    std::cerr << "Error reading " << fn << ": " << what << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+// Reference loader going through the rapidjson DOM : O(n), single core
+inline Instance loadDOM(const std::string &fn)
+{
+    std::ifstream in(fn, std::ifstream::in | std::ifstream::binary);
+    if (!in.is_open())
+        loadError(fn, "cannot open file");
+
+    rapidjson::IStreamWrapper isw{in};
+    rapidjson::Document doc{};
+    doc.ParseStream(isw);
+    if (doc.HasParseError())
+        loadError(fn, "parse error at offset " + std::to_string(doc.GetErrorOffset()));
+
+    Instance inst;
+    inst.radius = doc["radius"].GetDouble();
+    const rapidjson::Value &jspoints = doc["points"];
+    inst.x.reserve(jspoints.Size());
+    inst.y.reserve(jspoints.Size());
+    for (auto &jspoint : jspoints.GetArray())
+    {
+        inst.x.push_back(jspoint["x"].GetDouble());
+        inst.y.push_back(jspoint["y"].GetDouble());
+
+        // Points without "r" have the global radius
+        auto r = jspoint.FindMember("r");
+        bool hasR = r != jspoint.MemberEnd();
+        if (hasR || !inst.r.empty())
+        {
+            inst.r.resize(inst.x.size() - 1, inst.radius);
+            inst.r.push_back(hasR ? r->value.GetDouble() : inst.radius);
+        }
+    }
+    return inst;
+}
+
+namespace loader_detail
+{
+    // SAX handler storing the number of the value it is given.
+    // Integers are converted the same way rapidjson::Value::GetDouble does,
+    // so both loaders give the exact same doubles.
+    struct NumberHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, NumberHandler>
+    {
+        double value = 0;
+        bool isNumber = false;
+
+        bool Default() { isNumber = false; return true; }
+        bool Int(int i) { return set(i); }
+        bool Uint(unsigned u) { return set(u); }
+        bool Int64(int64_t i) { return set(static_cast<double>(i)); }
+        bool Uint64(uint64_t u) { return set(static_cast<double>(u)); }
+        bool Double(double d) { return set(d); }
+        bool set(double d) { value = d; isNumber = true; return true; }
+    };
+
+    // SAX handler for one {"x": .., "y": .., "r": ..} object of the points
+    // array, "r" being optional
+    struct PointHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, PointHandler>
+    {
+        enum Field { None, X, Y, R } field = None;
+        double x = 0, y = 0, r = 0;
+        int seen = 0; // Bit 0 for x, bit 1 for y, bit 2 for r
+
+        bool Key(const char *str, rapidjson::SizeType len, bool)
+        {
+            std::string_view key(str, len);
+            field = key == "x" ? X : key == "y" ? Y : key == "r" ? R : None;
+            return true;
+        }
+        bool Int(int i) { return set(i); }
+        bool Uint(unsigned u) { return set(u); }
+        bool Int64(int64_t i) { return set(static_cast<double>(i)); }
+        bool Uint64(uint64_t u) { return set(static_cast<double>(u)); }
+        bool Double(double d) { return set(d); }
+        bool set(double d)
+        {
+            if (field == X) { x = d; seen |= 1; }
+            if (field == Y) { y = d; seen |= 2; }
+            if (field == R) { r = d; seen |= 4; }
+            field = None;
+            return true;
+        }
+    };
+
+    inline const char *skipSpaces(const char *p, const char *end)
+    {
+        while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+            ++p;
+        return p;
+    }
+
+    inline std::size_t countObjects(const char *begin, const char *end)
+    {
+        return std::count(begin, end, '{');
+    }
+
+    inline bool hasRadii(const char *begin, const char *end)
+    {
+        return std::string_view(begin, end - begin).find("\"r\"") != std::string_view::npos;
+    }
+
+    // Parses every object starting in [begin, end) into x, y and, when it
+    // is not null, r (defaulting to radius). Returns false on a malformed point.
+    inline bool parseObjects(const char *begin, const char *end,
+                             double *x, double *y, double *r, double radius)
+    {
+        rapidjson::Reader reader;
+        std::size_t k = 0;
+        const char *p = begin;
+        while ((p = static_cast<const char *>(std::memchr(p, '{', end - p))))
+        {
+            rapidjson::StringStream ss(p);
+            PointHandler handler;
+            reader.Parse<rapidjson::kParseStopWhenDoneFlag>(ss, handler);
+            if (reader.HasParseError() || (handler.seen & 3) != 3)
+                return false;
+            x[k] = handler.x;
+            y[k] = handler.y;
+            if (r)
+                r[k] = handler.seen & 4 ? handler.r : radius;
+            ++k;
+            p += ss.Tell();
+            if (p >= end)
+                break;
+        }
+        return true;
+    }
+}
+
+// Multi-threaded loader.
+// Top-level keys are read with a rapidjson::Reader, the "points" array is
+// split in chunks at object boundaries, counted, then parsed in parallel
+// straight into the preallocated x and y arrays.
+inline Instance loadParallel(const std::string &fn, unsigned threads = 0)
+{
+    using namespace loader_detail;
+
+    std::string text;
+    {
+        std::ifstream in(fn, std::ifstream::in | std::ifstream::binary);
+        if (!in.is_open())
+            loadError(fn, "cannot open file");
+        in.seekg(0, std::ios::end);
+        text.resize(in.tellg());
+        in.seekg(0, std::ios::beg);
+        in.read(text.data(), text.size());
+    }
+
+    const char *p = text.data();
+    const char *end = p + text.size();
+    const char *pointsBegin = nullptr, *pointsEnd = nullptr;
+    bool hasRadius = false;
+    Instance inst;
+
+    // Structural scan of the top-level object
+    p = skipSpaces(p, end);
+    if (p == end || *p++ != '{')
+        loadError(fn, "expected an object");
+    for (;;)
+    {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '}')
+            break;
+        if (p == end || *p++ != '"')
+            loadError(fn, "expected a key");
+        const char *keyEnd = p;
+        while (keyEnd < end && *keyEnd != '"')
+            keyEnd += *keyEnd == '\\' ? 2 : 1;
+        if (keyEnd >= end)
+            loadError(fn, "unterminated key");
+        std::string_view key(p, keyEnd - p);
+        p = skipSpaces(keyEnd + 1, end);
+        if (p == end || *p++ != ':')
+            loadError(fn, "expected ':'");
+        p = skipSpaces(p, end);
+
+        if (key == "points")
+        {
+            // Points are flat objects of numbers: the first ']' closes the array
+            if (p == end || *p != '[')
+                loadError(fn, "\"points\" is not an array");
+            pointsBegin = p + 1;
+            pointsEnd = static_cast<const char *>(std::memchr(pointsBegin, ']', end - pointsBegin));
+            if (!pointsEnd)
+                loadError(fn, "unterminated \"points\" array");
+            p = pointsEnd + 1;
+        }
+        else
+        {
+            rapidjson::Reader reader;
+            rapidjson::StringStream ss(p);
+            NumberHandler handler;
+            reader.Parse<rapidjson::kParseStopWhenDoneFlag>(ss, handler);
+            if (reader.HasParseError())
+                loadError(fn, "parse error at offset " + std::to_string(p - text.data() + reader.GetErrorOffset()));
+            if (key == "radius" && handler.isNumber)
+            {
+                inst.radius = handler.value;
+                hasRadius = true;
+            }
+            p += ss.Tell();
+        }
+
+        p = skipSpaces(p, end);
+        if (p < end && *p == ',')
+            ++p;
+    }
+    if (!pointsBegin || !hasRadius)
+        loadError(fn, "missing \"points\" or \"radius\"");
+
+    // Chunks of at least 1 MiB, cut right before an object
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t length = pointsEnd - pointsBegin;
+    threads = (unsigned) std::clamp<std::size_t>(length >> 20, 1, threads);
+
+    std::vector<const char *> cuts(threads + 1, pointsEnd);
+    cuts[0] = pointsBegin;
+    for (unsigned t = 1; t < threads; ++t)
+    {
+        const char *c = std::max(cuts[t - 1], pointsBegin + length * t / threads);
+        const char *brace = static_cast<const char *>(std::memchr(c, '{', pointsEnd - c));
+        cuts[t] = brace ? brace : pointsEnd;
+    }
+
+    auto parallel = [threads](auto &&job)
+    {
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t)
+            workers.emplace_back(job, t);
+        job(0);
+        for (auto &w : workers)
+            w.join();
+    };
+
+    // Pass 1 : count the objects of each chunk, then prefix sums
+    std::vector<std::size_t> offsets(threads + 1, 0);
+    std::vector<char> radii(threads, 0);
+    parallel([&](unsigned t) {
+        offsets[t + 1] = countObjects(cuts[t], cuts[t + 1]);
+        radii[t] = hasRadii(cuts[t], cuts[t + 1]);
+    });
+    for (unsigned t = 0; t < threads; ++t)
+        offsets[t + 1] += offsets[t];
+
+    // Pass 2 : parse every chunk at its own offset
+    inst.x.resize(offsets[threads]);
+    inst.y.resize(offsets[threads]);
+    if (std::count(radii.begin(), radii.end(), 1))
+        inst.r.resize(offsets[threads]);
+    std::vector<char> ok(threads, 0);
+    parallel([&](unsigned t) {
+        ok[t] = parseObjects(cuts[t], cuts[t + 1],
+                             inst.x.data() + offsets[t], inst.y.data() + offsets[t],
+                             inst.r.empty() ? nullptr : inst.r.data() + offsets[t],
+                             inst.radius);
+    });
+    if (std::count(ok.begin(), ok.end(), 0))
+        loadError(fn, "malformed point in \"points\"");
+
+    return inst;
+}
+
+namespace loader_detail
+{
+    // SAX handler for a whole instance, for files that don't fit in memory
+    template <class OnRadius, class OnPoint>
+    struct StreamHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, StreamHandler<OnRadius, OnPoint>>
+    {
+        OnRadius &onRadius;
+        OnPoint &onPoint;
+        int depth = 0;
+        bool inPoints = false, isRadius = false;
+        bool perPointRadius = false;
+        PointHandler point;
+
+        StreamHandler(OnRadius &r, OnPoint &p) : onRadius(r), onPoint(p) {}
+
+        bool Key(const char *str, rapidjson::SizeType len, bool copy)
+        {
+            if (depth == 1)
+            {
+                std::string_view key(str, len);
+                isRadius = key == "radius";
+                inPoints = key == "points";
+                return true;
+            }
+            return point.Key(str, len, copy);
+        }
+        bool StartObject()
+        {
+            if (++depth == 2 && inPoints)
+                point = PointHandler();
+            return true;
+        }
+        bool EndObject(rapidjson::SizeType)
+        {
+            if (depth-- == 2 && inPoints)
+            {
+                perPointRadius |= (point.seen & 4) != 0;
+                if ((point.seen & 3) != 3 || perPointRadius)
+                    return false;
+                onPoint(point.x, point.y);
+            }
+            return true;
+        }
+        bool Int(int i) { return set(i); }
+        bool Uint(unsigned u) { return set(u); }
+        bool Int64(int64_t i) { return set(static_cast<double>(i)); }
+        bool Uint64(uint64_t u) { return set(static_cast<double>(u)); }
+        bool Double(double d) { return set(d); }
+        bool set(double d)
+        {
+            if (depth == 1 && isRadius)
+                onRadius(d);
+            else if (depth == 2 && inPoints)
+                point.set(d);
+            return true;
+        }
+    };
+}
+
+// Reads an instance in constant memory, calling onRadius(r) and
+// onPoint(x, y) in file order, with the same doubles as the other loaders.
+// Only instances with a single radius are supported.
+template <class OnRadius, class OnPoint>
+void streamInstance(const std::string &fn, OnRadius &&onRadius, OnPoint &&onPoint)
+{
+    std::FILE *in = std::fopen(fn.c_str(), "rb");
+    if (!in)
+        loadError(fn, "cannot open file");
+
+    char buffer[1 << 16];
+    rapidjson::FileReadStream frs(in, buffer, sizeof(buffer));
+    loader_detail::StreamHandler<OnRadius, OnPoint> handler(onRadius, onPoint);
+    rapidjson::Reader reader;
+    reader.Parse(frs, handler);
+    std::fclose(in);
+
+    if (handler.perPointRadius)
+        loadError(fn, "per-point radii need the in-memory solver");
+    if (reader.HasParseError())
+        loadError(fn, "parse error at offset " + std::to_string(reader.GetErrorOffset()));
+}
+
+#endif
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <iostream>
 #include <cmath>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -9,6 +10,12 @@
 #include <tuple>
 #include <functional>
 #include <numeric>
+#include <cstdint>
+#include <climits>
+#include <bit>
+#include <optional>
+#include <atomic>
+#include <thread>
 
 namespace std
 {
@@ -23,139 +30,168 @@ namespace std
         }
     };
 }
-#include "rapidjson/document.h"
-#include "rapidjson/istreamwrapper.h"
+#include "../../common/radixsort.hpp"
+#include "loader.hpp"
+#include "point.hpp"
+#include "index.hpp"
+#include "service.hpp"
+#include "svg.hpp"
+#include "tiled.hpp"
 
-template <class Number>
-struct Point
+inline Width exactWidth(const Instance &inst)
 {
-    Number x, y;
-    Point(Number _x, Number _y) : x(_x), y(_y) {}
-    double distance(Point<Number> p) const
+    WidthCheck check;
+    for (std::size_t i = 0; i < inst.size(); ++i)
     {
-        return sqrt((x - p.x) * (x - p.x) + (y - p.y) * (y - p.y));
+        check.account(inst.x[i]);
+        check.account(inst.y[i]);
     }
+    return check.result();
+}
 
-    // Just the distance without the square root (faster)
-    double distance2(Point<Number> p) const
-    {
-        return (x - p.x) * (x - p.x) + (y - p.y) * (y - p.y);
-    }
-    bool operator==(Point p) const
-    {
-        return p.x == x && p.y == y;
-    }
+// Greedy rules of manyRuns
+enum class Rules
+{
+    Auto,      // Both when the degrees are cheap enough, else Direction
+    Direction, // Decreasing projection on a direction
+    Degree,    // Fewest overlapping disks first
+    Both
 };
 
 template <class Number>
 class Solver
 {
+    using Wide = typename Arithmetic<Number>::Wide;
+
     std::vector<Point<Number>> pts;
-    Number radius;
+    double radius;
+    Wide dist_max2; // (2 * radius)^2, rounded down for integers
+    std::vector<double> radii; // Per-point radii, empty if all are radius
     
-    using Cell = Point<long long>;
+    // Built once, shared by every greedy run
+    std::optional<GridIndex<Number>> grid;
+    std::optional<KdIndex<Number>> kdtree;
+    std::optional<MultiGridIndex<Number>> multigrid;
 
-    struct CellHash {
-        size_t operator()(const Cell& c) const noexcept {
-            // Usual mix
-            size_t h1 = std::hash<long long>{}(c.x);
-            size_t h2 = std::hash<long long>{}(c.y);
-            return h1 ^ (h2 << 1);
+    std::vector<int> fixed;
+    // Overlapping disks, as adjacency lists, computed on first use
+    std::vector<int> degree;
+    std::vector<std::size_t> overlapStart;
+    std::vector<int> overlaps;
+    static constexpr std::size_t maxOverlaps = 1 << 27; // 512 MiB
+
+    // Calls f(j) for every j != i overlapping i, from the lists if built
+    template <class F>
+    void forEachOverlap(int i, F &&f) const
+    {
+        if (!overlapStart.empty() && overlaps.size() == overlapStart.back())
+        {
+            for (std::size_t k = overlapStart[i]; k < overlapStart[i + 1]; ++k)
+                f(overlaps[k]);
+            return;
         }
-    };
+        forEachNear(i, [&](int j) {
+            if (j != i)
+                f(j);
+        });
+    }
 
-    // Build cell key with floor to handle negatives
-    static Cell key_of(const Point<Number> &p, Number cellSize)
+    // Calls f(j) for every j overlapping i, with the index in use
+    template <class F>
+    void forEachNear(int i, F &&f) const
     {
-        long double L = static_cast<long double>(cellSize);
-        long double fx = std::floor(static_cast<long double>(p.x) / L);
-        long double fy = std::floor(static_cast<long double>(p.y) / L);
-        return {static_cast<long long>(fx), static_cast<long long>(fy)};
+        if (multigrid)
+            multigrid->forEachNear(i, f);
+        else if (kdtree)
+            kdtree->forEachNear(i, f);
+        else
+            grid->forEachNear(i, f);
     }
 
 public:
-    Solver(std::string fn)
+    Solver(const Instance &inst, IndexKind kind = IndexKind::Auto)
     {
-        // Open file : O(1)
-        std::ifstream in(fn, std::ifstream::in | std::ifstream::binary);
-        rapidjson::IStreamWrapper isw{in};
-        rapidjson::Document doc{};
-        doc.ParseStream(isw);
-
-        // Load points in a vector : O(n)
-        const rapidjson::Value &jspoints = doc["points"];
-        for (auto &jspoint : jspoints.GetArray())
+        // Convert the loaded coordinates : O(n)
+        pts.reserve(inst.size());
+        for (std::size_t i = 0; i < inst.size(); ++i)
         {
-            Number x = jspoint["x"].GetDouble();
-            Number y = jspoint["y"].GetDouble();
+            Number x = inst.x[i];
+            Number y = inst.y[i];
             pts.push_back(Point<Number>{x, y});
         }
 
-        // Load radius value : O(1)
-        radius = doc["radius"].GetDouble();
-        std::cout << "Read " << pts.size()
-                  << " points with radius " << radius
-                  << "." << std::endl;
+        radius = inst.radius;
+        dist_max2 = squaredDiameter<Wide>(radius);
+
+        // Disks of different sizes always need the multi-level grid
+        if (!inst.r.empty())
+        {
+            radii = inst.r;
+            multigrid.emplace(pts, radii);
+            return;
+        }
+
+        if (kind == IndexKind::Auto)
+            kind = chooseIndex(pts, radius);
+        if (kind == IndexKind::KdTree)
+            kdtree.emplace(pts, dist_max2);
+        else
+            grid.emplace(pts, radius, dist_max2);
+    }
+
+    // Points chosen before any other by greedy, and not part of its result
+    void setFixed(std::vector<int> _fixed)
+    {
+        fixed = std::move(_fixed);
     }
 
-    std::vector<Point<Number>> greedy(Point<Number> dir)
+    // Returns the indices of the chosen points
+    std::vector<int> greedy(Point<long long> dir)
+    {
+        if (multigrid)
+            return greedy(*multigrid, dir);
+        return kdtree ? greedy(*kdtree, dir) : greedy(*grid, dir);
+    }
+
+    template <class Index>
+    std::vector<int> greedy(const Index &index, Point<long long> dir)
+    {
+        return greedy(order(dir), [&](int ip, auto &&f) { index.forEachNear(ip, f); });
+    }
+
+    // Indices sorted by their projection on dir
+    std::vector<int> order(Point<long long> dir) const
     {
         // List of indices
         std::vector<int> indexes(pts.size());
         std::iota(indexes.begin(), indexes.end(), 0); // range(0, n)
         
-        // Sort the indexes depending on dir
+        // Sort the indexes depending on dir, each projection computed once
         auto proj = [&](int i) {
-            return pts[i].x * dir.x + pts[i].y * dir.y;
+            return Wide(pts[i].x) * dir.x + Wide(pts[i].y) * dir.y;
         };
-        std::sort(indexes.begin(), indexes.end(), /*cmp*/[&](int i, int j) {
-            return proj(i) < proj(j);
-        });
-
-        // Instantiate a grid of indexes of point
-        const Number cellSize = Number(2) * radius;
-        std::unordered_map<Cell, std::vector<int>, CellHash> grid;
-        
-        // Match each point with a cell on a grid
-        int ptsSize = (int) pts.size();
-        for (int i = 0; i < ptsSize; ++i) {
-            grid[key_of(pts[i], cellSize)].push_back(i);
-        }
+        radixSort(indexes, proj); //! O(n)
+        return indexes;
+    }
 
+    // Greedy on points sorted by order(dir), near(i, f) calling f on the
+    // points overlapping i
+    template <class Near>
+    std::vector<int> greedy(const std::vector<int> &indexes, Near &&near) const
+    {
         std::vector<uint8_t> alive(pts.size(), 1);
 
         // Lambda that kills p's neighbours using its index (ip)
-        auto kill_neighbours = [&](int ip) //! O(n)
+        auto kill_neighbours = [&](int ip)
         {
-            const Number dist_max2 = Number(4) * radius * radius;
-            const auto &p = pts[ip]; // Fetch p
-            
-            // Get cell_x and cell_y which is p / cellSize
-            auto [cx, cy] = key_of(p, cellSize);
-
-            // Search around the target cell with a delta betwen -1 and 1
-            for (long long dx = -1; dx <= 1; ++dx)
-                for (long long dy = -1; dy <= 1; ++dy)
-                {
-                    // Find cell with binary search 
-                    auto it = grid.find({cx + dx, cy + dy}); //! O(log n)
-                    if (it == grid.end())
-                        continue;
-                    
-                    // Iterate through all neighbours
-                    for (int j : it->second) //! O(n)
-                    {
-                        if (!alive[j]) // ignore if dead
-                            continue;
-                        
-                        // Kill using squared distance for efficiency
-                        if (p.distance2(pts[j]) <= dist_max2)
-                            alive[j] = 0; // will kill p eventually
-                    }
-                }
+            // Will kill p eventually
+            near(ip, [&](int j) { alive[j] = 0; });
         };
 
-        std::vector<Point<Number>> solution;
+        for (int i : fixed)
+            kill_neighbours(i);
+
+        std::vector<int> solution;
         solution.reserve(pts.size()); // ensure no reallocation is necessary
 
         // Main algorithm, idea is unchanged but should now be O(n²)
@@ -164,130 +200,554 @@ public:
             int i = indexes[k];
             if (!alive[i])  // ignore dead 
                 continue;
-            solution.push_back(pts[i]);
-            kill_neighbours(i); //! O(n)
+            solution.push_back(i);
+            kill_neighbours(i);
         }
         return solution;
     }
 
-    std::vector<Point<Number>> manyRuns(int angles = 8)
+    // Overlap lists, built on first use by two parallel passes over the
+    // index: one counting, one filling. O(n + overlaps) memory, up to
+    // maxOverlaps lists, only the degrees are kept beyond.
+    const std::vector<int> &degrees(unsigned threads = 0)
     {
-        std::vector<Point<Number>> bestSolution;
-        std::cout << "Found " << angles
-                  << " independent sets of size:" << std::flush;
+        if (overlapStart.size() == pts.size() + 1)
+            return degree;
+        const int n = (int) pts.size();
+        degree.assign(n, 0);
 
-        for (int i = 0; i < angles; ++i)
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        auto parallel = [&](auto &&job)
         {
-            double angle = i * 2 * M_PI / angles;
-            Point<long long int> dir(65536 * cos(angle), 65536 * sin(angle));
-            std::vector<Point<long long int>> solution = greedy(dir);
-            std::cout << " " << solution.size() << std::flush;
-            if (bestSolution.size() < solution.size())
+            const int block = 4096;
+            std::atomic<int> next = 0;
+            auto worker = [&]()
             {
-                bestSolution = solution;
-                std::cout << "*" << std::flush;
-            }
-        }
-        return bestSolution;
+                for (int b; (b = next.fetch_add(block)) < n;)
+                    for (int i = b; i < std::min(n, b + block); ++i)
+                        job(i);
+            };
+            std::vector<std::thread> workers;
+            for (unsigned t = 1; t < threads; ++t)
+                workers.emplace_back(worker);
+            worker();
+            for (auto &w : workers)
+                w.join();
+        };
+
+        parallel([&](int i) {
+            int count = -1; // Not itself
+            forEachNear(i, [&](int) { ++count; });
+            degree[i] = count;
+        });
+
+        overlapStart.assign(n + 1, 0);
+        for (int i = 0; i < n; ++i)
+            overlapStart[i + 1] = overlapStart[i] + degree[i];
+        if (overlapStart[n] > maxOverlaps) // The index answers instead
+            return degree;
+        overlaps.resize(overlapStart[n]);
+
+        parallel([&](int i) {
+            std::size_t k = overlapStart[i];
+            forEachNear(i, [&](int j) {
+                if (j != i)
+                    overlaps[k++] = j;
+            });
+        });
+        return degree;
     }
 
-    void writeSolutionSVG(std::string fn, std::vector<Point<Number>> solution,
-                          int image_size = 1000)
+    // Greedy taking the disk with the fewest live overlaps first.
+    // Degrees only drop, as disks die, and a bucket queue keeps them sorted
+    // in O(1) per change: O(n + overlaps) for the whole run. Ties are broken
+    // by the projection on dir, so each direction gives another rule.
+    std::vector<int> minDegreeGreedy(Point<long long> dir)
     {
-        Number x0 = std::min_element(pts.begin(), pts.end(),
-                                     [](Point<Number> a, Point<Number> b)
-                                     { return a.x < b.x; })
-                        ->x -
-                    radius;
-        Number y0 = std::min_element(pts.begin(), pts.end(),
-                                     [](Point<Number> a, Point<Number> b)
-                                     { return a.y < b.y; })
-                        ->y -
-                    radius;
-        Number x1 = std::max_element(pts.begin(), pts.end(),
-                                     [](Point<Number> a, Point<Number> b)
-                                     { return a.x < b.x; })
-                        ->x +
-                    radius;
-        Number y1 = std::max_element(pts.begin(), pts.end(),
-                                     [](Point<Number> a, Point<Number> b)
-                                     { return a.y < b.y; })
-                        ->y +
-                    radius;
-        Number input_size = std::max(x1 - x0, y1 - y0);
-        double image_radius = (double)image_size * radius / input_size;
-
-        auto inputToImagePt = [x0, y1, image_size, input_size](Point<Number> p)
+        const int n = (int) pts.size();
+        std::vector<int> deg = degrees();
+        int maxDeg = n ? *std::max_element(deg.begin(), deg.end()) : 0;
+
+        // One doubly linked list per degree
+        std::vector<int> head(maxDeg + 1, -1), next(n), prev(n);
+        auto link = [&](int v) {
+            prev[v] = -1;
+            next[v] = head[deg[v]];
+            if (next[v] >= 0)
+                prev[next[v]] = v;
+            head[deg[v]] = v;
+        };
+        auto unlink = [&](int v) {
+            if (prev[v] >= 0)
+                next[prev[v]] = next[v];
+            else
+                head[deg[v]] = next[v];
+            if (next[v] >= 0)
+                prev[next[v]] = prev[v];
+        };
+
+        // Linked by increasing projection: the biggest comes out first,
+        // like in greedy
+        for (int i : order(dir))
+            link(i);
+
+        std::vector<uint8_t> alive(n, 1);
+        std::vector<int> dying;
+        int minDeg = 0;
+
+        // Kills ip and the disks overlapping it, then updates the degrees
+        // around them
+        auto kill_neighbours = [&](int ip)
         {
-            Point<double> q((double)(p.x - x0) * image_size / input_size,
-                            (double)(y1 - p.y) * image_size / input_size);
-            return q;
+            dying.clear();
+            auto die = [&](int j) {
+                if (!alive[j])
+                    return;
+                alive[j] = 0;
+                unlink(j);
+                dying.push_back(j);
+            };
+            die(ip);
+            forEachOverlap(ip, die);
+
+            for (int u : dying)
+                forEachOverlap(u, [&](int w) {
+                    if (!alive[w])
+                        return;
+                    unlink(w);
+                    --deg[w];
+                    link(w);
+                    minDeg = std::min(minDeg, deg[w]);
+                });
         };
 
-        std::ofstream fsvg(fn);
-        fsvg << "<?xml version=\"1.0\" encoding=\"utf-8\"?>" << std::endl;
-        Point<double> image_size_xy = inputToImagePt(Point{x1, y0});
-        fsvg << "<svg xmlns=\"http://www.w3.org/2000/svg\""
-             << " version=\"1.1\" width=\""
-             << image_size_xy.x
-             << "\" height=\""
-             << image_size_xy.y
-             << "\">"
-             << std::endl;
-
-        for (auto input_p : pts)
+        for (int i : fixed)
+            if (alive[i])
+                kill_neighbours(i);
+
+        std::vector<int> solution;
+        for (;;)
         {
-            auto it = std::find(solution.begin(), solution.end(), input_p);
-            if (it == solution.end()) {
-                Point<double> image_p = inputToImagePt(input_p);
-                fsvg << " <circle"
-                     << " stroke=\"black\""
-                     << " fill=\"none\""
-                     << " stroke-width=\"2\""
-                     << " cx=\""<< image_p.x << "\""
-                     << " cy=\"" << image_p.y << "\""
-                     << " r=\"" << image_radius << "\""
-                     << ">" << std::endl;
-
-                fsvg << "  <title>"
-                     << "(" << input_p.x << "," << input_p.y << ")"
-                     << "</title>" << std::endl;
-
-                fsvg << " </circle>" << std::endl;
-            }
+            while (minDeg <= maxDeg && head[minDeg] < 0)
+                ++minDeg;
+            if (minDeg > maxDeg)
+                break;
+            int i = head[minDeg];
+            solution.push_back(i);
+            kill_neighbours(i);
         }
+        return solution;
+    }
+
+    // Whether i and j overlap, with their own radii if any
+    bool overlap(int i, int j) const
+    {
+        if (radii.empty())
+            return pts[i].distance2(pts[j]) <= dist_max2;
+        long double reach = (long double)radii[i] + radii[j];
+        return (long double)pts[i].distance2(pts[j]) <= reach * reach;
+    }
 
-        for (auto input_p : solution)
+    // Upper bound on any independent set: a greedy partition into cliques,
+    // each holding at most one chosen disk. Sweeping from the left, the
+    // first uncovered point starts a clique, and its uncovered neighbours
+    // join it from the closest one if they overlap every member.
+    std::size_t cliqueCoverBound() const
+    {
+        std::vector<uint8_t> covered(pts.size(), 0);
+        std::vector<int> clique, candidates;
+        std::size_t cliques = 0;
+
+        for (int p : order(Point<long long>(-65536, 0)))
         {
-            Point<double> image_p = inputToImagePt(input_p);
-            fsvg << " <circle"
-                 << " stroke=\"blue\""
-                 << " fill=\"none\""
-                 << " stroke-width=\"2\""
-                 << " cx=\"" << image_p.x << "\" cy=\"" << image_p.y << "\""
-                 << " r=\"" << image_radius << "\""
-                 << ">" << std::endl;
-
-            fsvg << "  <title>"
-                 << "(" << input_p.x << "," << input_p.y << ")"
-                 << "</title>" << std::endl;
-                 
-            fsvg << " </circle>" << std::endl;
+            if (covered[p])
+                continue;
+            ++cliques;
+
+            candidates.clear();
+            forEachNear(p, [&](int j) {
+                if (!covered[j] && j != p)
+                    candidates.push_back(j);
+            });
+            radixSort(candidates, [&](int j) { return pts[p].distance2(pts[j]); });
+
+            covered[p] = 1;
+            clique.assign(1, p);
+            for (int q : candidates)
+                if (std::all_of(clique.begin(), clique.end(), [&](int c) { return overlap(q, c); }))
+                {
+                    covered[q] = 1;
+                    clique.push_back(q);
+                }
         }
+        return cliques;
+    }
 
-        fsvg << "</svg>" << std::endl;
+    // Whether the min-degree rules are worth their O(n + overlaps) runs:
+    // always for per-point radii, else when a disk of radius r (the solver
+    // radius by default) overlaps few others
+    bool degreeRulesPay(double r = 0) const
+    {
+        const double maxAverageDegree = 64;
+        return multigrid || estimateScanned(pts, r > 0 ? r : radius) * M_PI / 9 <= maxAverageDegree;
     }
+
+    // Best of the directional greedy runs, then of the min-degree ones.
+    // Stops as soon as a solution reaches the upper bound, if given.
+    std::vector<int> manyRuns(int angles = 8, Rules rules = Rules::Auto,
+                              std::size_t bound = SIZE_MAX)
+    {
+        if (rules == Rules::Auto)
+            rules = degreeRulesPay() ? Rules::Both : Rules::Direction;
+
+        std::vector<int> bestSolution;
+        auto family = [&](const char *name, auto &&run)
+        {
+            if (bestSolution.size() >= bound)
+                return;
+            std::cout << "Found " << angles << name
+                      << " independent sets of size:" << std::flush;
+            for (int i = 0; i < angles && bestSolution.size() < bound; ++i)
+            {
+                std::vector<int> solution = run(direction(i, angles));
+                std::cout << " " << solution.size() << std::flush;
+                if (bestSolution.size() < solution.size())
+                {
+                    bestSolution = solution;
+                    std::cout << "*" << std::flush;
+                }
+            }
+        };
+
+        if (rules != Rules::Degree)
+            family("", [&](Point<long long> dir) { return greedy(dir); });
+        if (rules == Rules::Both && bestSolution.size() < bound)
+            std::cout << std::endl;
+        if (rules != Rules::Direction)
+            family(" min-degree", [&](Point<long long> dir) { return minDegreeGreedy(dir); });
+        return bestSolution;
+    }
+
+    // Best directional greedy size for each of radii, none above the solver
+    // radius: the sizes of manyRuns with Rules::Direction. The index and the
+    // `angles` sort orders are shared by every radius, radii are spread over
+    // the threads.
+    std::vector<std::size_t> sweep(const std::vector<double> &radii,
+                                   unsigned threads = 0, int angles = 8) const
+    {
+        std::vector<std::vector<int>> orders(angles);
+        for (int i = 0; i < angles; ++i)
+            orders[i] = order(direction(i, angles));
+
+        std::vector<std::size_t> best(radii.size(), 0);
+        auto solve = [&](std::size_t k)
+        {
+            Wide d2 = squaredDiameter<Wide>(radii[k]);
+            auto near = [&](int ip, auto &&f) {
+                if (kdtree)
+                    kdtree->forEachNear(ip, d2, f);
+                else
+                    grid->forEachNear(ip, d2, f);
+            };
+            for (const auto &indexes : orders)
+                best[k] = std::max(best[k], greedy(indexes, near).size());
+        };
+
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<std::size_t> next = 0;
+        auto worker = [&]()
+        {
+            for (std::size_t k; (k = next++) < radii.size();)
+                solve(k);
+        };
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t)
+            workers.emplace_back(worker);
+        worker();
+        for (auto &w : workers)
+            w.join();
+        return best;
+    }
+
+    // Draws every disk, the solution in blue. On huge instances, only one
+    // non-solution disk out of `others` is drawn (0 draws none of them).
+    void writeSolutionSVG(std::string fn, const std::vector<int> &solution,
+                          int others = 1, int image_size = 1000)
+    {
+        ::writeSolutionSVG(fn, pts, radius, solution, others, image_size, radii);
+    }
+
+    bool usesKdTree() const { return kdtree.has_value(); }
+    std::size_t radiusClasses() const { return multigrid ? multigrid->levelCount() : 0; }
+    const std::vector<Point<Number>> &points() const { return pts; }
+    double getRadius() const { return radius; }
 };
 
-int main(int argc, char **argv)
+// Returns the value of a "--name=value" option, or nullptr if absent
+static const char *option(int argc, char **argv, const std::string &name)
+{
+    std::string prefix = "--" + name + "=";
+    for (int i = 3; i < argc; ++i)
+        if (std::string(argv[i]).starts_with(prefix))
+            return argv[i] + prefix.size();
+    return nullptr;
+}
+
+struct Options
+{
+    std::string svg;
+    int others = 1;
+    IndexKind index = IndexKind::Auto;
+    bool serve = false;
+    unsigned threads = 0;
+    std::vector<double> radii; // Radius sweep, the table goes to svg
+    Rules rules = Rules::Auto;
+};
+
+// Solves with the coordinates stored as Number
+template <class Number>
+void run(const Instance &inst, const Options &opts)
 {
-    Solver<long long int> solver(argv[1]);
+    Solver<Number> solver(inst, opts.index);
+    std::cout << "Read " << inst.size()
+              << " points with radius " << inst.radius
+              << "." << std::endl;
+    if (solver.usesKdTree())
+        std::cout << "Using a k-d tree index." << std::endl;
+    if (solver.radiusClasses())
+        std::cout << "Using a multi-level grid of " << solver.radiusClasses()
+                  << " radius classes." << std::endl;
 
-    std::vector<Point<long long int>> solution = solver.manyRuns();
+    std::size_t bound = solver.cliqueCoverBound();
+    std::vector<int> solution = solver.manyRuns(8, opts.rules, bound);
 
     std::cout << std::endl
-              << "Best: " << solution.size() << std::endl;
-    solver.writeSolutionSVG(argv[2], solution);
+              << "Best: " << solution.size()
+              << " (upper bound " << bound << ", gap "
+              << 100.0 * (bound - solution.size()) / std::max<std::size_t>(bound, 1)
+              << "%)" << std::endl;
+    solver.writeSolutionSVG(opts.svg, solution, opts.others);
+
+    if (opts.serve && !inst.r.empty())
+        std::cerr << "--serve needs disks of a single radius." << std::endl;
+    else if (opts.serve)
+    {
+        DynamicSolver<Number> service(solver.points(), solver.getRadius(), solution);
+        std::cout << "Serving insert/delete/query commands." << std::endl;
+        service.serve(std::cin, std::cout);
+    }
+}
+
+static const char *rulesName(Rules rules)
+{
+    return rules == Rules::Direction ? "direction"
+         : rules == Rules::Degree    ? "degree"
+         : rules == Rules::Both      ? "both"
+                                     : "auto";
+}
+
+// Best size for every radius of the sweep, written as a CSV table with the
+// rules used. Each size is the one of a separate run with that radius:
+// direction-only radii share the index of the largest radius, the others
+// need overlap lists of their own, and get a solver each.
+template <class Number>
+void runSweep(const Instance &inst, const Options &opts)
+{
+    Solver<Number> solver(inst, opts.index);
+    std::cout << "Read " << inst.size() << " points, sweeping "
+              << opts.radii.size() << " radii." << std::endl;
+
+    // Rules of each radius, as manyRuns would pick them
+    std::vector<Rules> rules(opts.radii.size(), opts.rules);
+    std::vector<double> shared;
+    std::vector<std::size_t> sharedAt;
+    for (std::size_t k = 0; k < rules.size(); ++k)
+    {
+        if (rules[k] == Rules::Auto)
+            rules[k] = solver.degreeRulesPay(opts.radii[k]) ? Rules::Both : Rules::Direction;
+        if (rules[k] == Rules::Direction)
+        {
+            shared.push_back(opts.radii[k]);
+            sharedAt.push_back(k);
+        }
+    }
+
+    std::vector<std::size_t> sizes(opts.radii.size(), 0);
+    std::vector<std::size_t> sharedSizes = solver.sweep(shared, opts.threads);
+    for (std::size_t k = 0; k < shared.size(); ++k)
+        sizes[sharedAt[k]] = sharedSizes[k];
+
+    Instance at = inst;
+    for (std::size_t k = 0; k < rules.size(); ++k)
+    {
+        if (rules[k] == Rules::Direction)
+            continue;
+        at.radius = opts.radii[k];
+        Solver<Number> single(at, opts.index);
+        std::cout << "Radius " << at.radius << ":" << std::endl;
+        sizes[k] = single.manyRuns(8, rules[k]).size();
+        std::cout << std::endl;
+    }
+
+    std::ofstream table(opts.svg);
+    table << "radius,size,rules\n";
+    for (std::size_t k = 0; k < sizes.size(); ++k)
+    {
+        table << opts.radii[k] << "," << sizes[k] << "," << rulesName(rules[k]) << "\n";
+        std::cout << "Radius " << opts.radii[k] << ": " << sizes[k]
+                  << " (" << rulesName(rules[k]) << " rules)" << std::endl;
+    }
+}
+
+// Out-of-core solve, one tile of the instance at a time
+template <class Number>
+void runTiled(const TiledInstance &tiled, const TiledOptions &tiling, const Options &opts)
+{
+    std::size_t total = solveTiled(tiled.store, tiled.radius, tiling,
+        [&](const Instance &inst, std::vector<int> fixed) {
+            Solver<Number> solver(inst, opts.index);
+            solver.setFixed(std::move(fixed));
+            std::vector<int> best;
+            for (int i = 0; i < 8; ++i)
+            {
+                std::vector<int> solution = solver.greedy(direction(i, 8));
+                if (best.size() < solution.size())
+                    best = std::move(solution);
+            }
+            return best;
+        });
+
+    std::cout << "Best: " << total << std::endl;
+    writeTiledSVG<Number>(opts.svg, tiled.store, tiled.radius,
+                  tiled.minx, tiled.miny, tiled.maxx, tiled.maxy, opts.others);
+}
+
+// Tells if a "--name" flag is given
+static bool flag(int argc, char **argv, const std::string &name)
+{
+    for (int i = 3; i < argc; ++i)
+        if (argv[i] == "--" + name)
+            return true;
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "./main <inputfile> <outputfile.svg>"
+                  << " [--others=K] [--loader=parallel|dom] [--threads=N]"
+                  << " [--index=auto|grid|kd] [--greedy=auto|direction|degree|both] [--serve]"
+                  << " [--tiles=DIR [--tile-size=CELLS] [--tile-budget=POINTS]]"
+                  << " [--radii=R1,R2,... (outputfile gets a CSV table)]" << std::endl;
+        return 1;
+    }
+
+    Options opts;
+    opts.svg = argv[2];
+
+    // Only draw one non-solution disk out of K (0 to skip them all)
+    if (const char *others = option(argc, argv, "others"))
+        opts.others = std::atoi(others);
+
+    // Spatial index, picked from the point density by default
+    if (const char *index = option(argc, argv, "index"))
+        opts.index = std::string(index) == "kd"     ? IndexKind::KdTree
+                   : std::string(index) == "grid" ? IndexKind::Grid
+                                                  : IndexKind::Auto;
+
+    // Greedy rules, the min-degree ones are skipped on dense instances
+    if (const char *greedy = option(argc, argv, "greedy"))
+        opts.rules = std::string(greedy) == "direction" ? Rules::Direction
+                   : std::string(greedy) == "degree"    ? Rules::Degree
+                   : std::string(greedy) == "both"      ? Rules::Both
+                                                        : Rules::Auto;
+
+    // Then keep the solution up to date from commands read on stdin
+    opts.serve = flag(argc, argv, "serve");
+
+    if (const char *threads = option(argc, argv, "threads"))
+        opts.threads = std::atoi(threads);
+
+    // Sizes for many radii of the same points, from a single index
+    if (const char *radii = option(argc, argv, "radii"))
+    {
+        std::stringstream list(radii);
+        std::string r;
+        while (std::getline(list, r, ','))
+            opts.radii.push_back(std::atof(r.c_str()));
+        if (opts.radii.empty() || *std::min_element(opts.radii.begin(), opts.radii.end()) <= 0)
+        {
+            std::cerr << "--radii needs positive radii" << std::endl;
+            return 1;
+        }
+    }
+
+    // Instances larger than memory are solved tile by tile from DIR
+    if (const char *dir = option(argc, argv, "tiles"))
+    {
+        TiledOptions tiling;
+        tiling.dir = dir;
+        if (const char *size = option(argc, argv, "tile-size"))
+            tiling.cells = std::atof(size);
+        if (const char *budget = option(argc, argv, "tile-budget"))
+            tiling.budget = std::strtoull(budget, nullptr, 10);
+        tiling.threads = opts.threads;
+
+        TiledInstance tiled = tileInstance(argv[1], tiling);
+        std::cout << "Read " << tiled.count
+                  << " points with radius " << tiled.radius
+                  << " in " << tiled.store.all().size() << " tiles." << std::endl;
+        switch (tiled.width)
+        {
+        case Width::Int32:
+            runTiled<int32_t>(tiled, tiling, opts);
+            break;
+        case Width::Float:
+            runTiled<float>(tiled, tiling, opts);
+            break;
+        case Width::Double:
+            runTiled<double>(tiled, tiling, opts);
+            break;
+        }
+        tiled.store.removeFiles();
+        return 0;
+    }
+
+    // The DOM loader is the slower reference the parallel one must match
+    const char *loader = option(argc, argv, "loader");
+    Instance inst = loader && std::string(loader) == "dom"
+                        ? loadDOM(argv[1])
+                        : loadParallel(argv[1], opts.threads);
+
+    // The index is built for the largest radius of the sweep
+    if (!opts.radii.empty())
+    {
+        if (!inst.r.empty())
+        {
+            std::cerr << "--radii needs disks of a single radius." << std::endl;
+            return 1;
+        }
+        inst.radius = *std::max_element(opts.radii.begin(), opts.radii.end());
+    }
+
+    switch (exactWidth(inst))
+    {
+    case Width::Int32:
+        std::cout << "Using int32 coordinates." << std::endl;
+        opts.radii.empty() ? run<int32_t>(inst, opts) : runSweep<int32_t>(inst, opts);
+        break;
+    case Width::Float:
+        std::cout << "Using float coordinates." << std::endl;
+        opts.radii.empty() ? run<float>(inst, opts) : runSweep<float>(inst, opts);
+        break;
+    case Width::Double:
+        std::cout << "Using double coordinates." << std::endl;
+        opts.radii.empty() ? run<double>(inst, opts) : runSweep<double>(inst, opts);
+        break;
+    }
 
     return 0;
 }
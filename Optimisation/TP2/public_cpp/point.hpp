@@ -0,0 +1,102 @@
+// BERTOLINI Garice
+#ifndef POINT_HPP
+#define POINT_HPP
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+// Type in which a coordinate type is computed with.
+// int32 coordinates use exact int64 squared distances.
+template <class Number>
+struct Arithmetic
+{
+    using Wide = double;
+};
+
+template <>
+struct Arithmetic<int32_t>
+{
+    using Wide = int64_t;
+};
+
+// (2 * radius)^2, rounded down when computed with integers
+template <class Wide>
+Wide squaredDiameter(double radius)
+{
+    long double d2 = 4.0L * radius * radius;
+    return std::is_integral_v<Wide> ? (Wide)std::floor(d2) : (Wide)d2;
+}
+
+template <class Number>
+struct Point
+{
+    using Wide = typename Arithmetic<Number>::Wide;
+
+    Number x, y;
+    Point(Number _x, Number _y) : x(_x), y(_y) {}
+    double distance(Point<Number> p) const
+    {
+        return sqrt((double)distance2(p));
+    }
+
+    // Just the distance without the square root (faster)
+    Wide distance2(Point<Number> p) const
+    {
+        Wide dx = Wide(x) - Wide(p.x);
+        Wide dy = Wide(y) - Wide(p.y);
+        return dx * dx + dy * dy;
+    }
+    bool operator==(Point p) const
+    {
+        return p.x == x && p.y == y;
+    }
+};
+
+// Direction of the i-th of `angles` greedy runs, scaled to integers
+inline Point<long long> direction(int i, int angles)
+{
+    double angle = i * 2 * M_PI / angles;
+    return Point<long long>(65536 * cos(angle), 65536 * sin(angle));
+}
+
+// Narrowest coordinate type holding every input value exactly
+enum class Width
+{
+    Int32,  // Integers below 2^30, int64 squared distances can't overflow
+    Float,  // At most 24 significant bits, exact double squared distances
+    Double  // Anything else
+};
+
+// Accumulates the values of an instance to find its Width
+class WidthCheck
+{
+    // Every value is a multiple of 2^low and below 2^high
+    int low = 0, high = INT_MIN;
+
+public:
+    void account(double v)
+    {
+        if (v == 0)
+            return;
+        int e;
+        double m = std::frexp(std::fabs(v), &e); // |v| = m * 2^e
+        uint64_t mantissa = (uint64_t)std::ldexp(m, 53);
+        low = std::min(low, e - 53 + std::countr_zero(mantissa));
+        high = std::max(high, e);
+    }
+
+    Width result() const
+    {
+        if (low >= 0 && high <= 30)
+            return Width::Int32;
+        if (high - low <= 24 && high <= 127 && low >= -126)
+            return Width::Float;
+        return Width::Double;
+    }
+};
+
+#endif
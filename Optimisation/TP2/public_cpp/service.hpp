@@ -0,0 +1,253 @@
+// BERTOLINI Garice
+#ifndef SERVICE_HPP
+#define SERVICE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "index.hpp"
+#include "point.hpp"
+#include "svg.hpp"
+
+// Long-running mode: keeps a maximal independent set of disks up to date
+// while points are inserted and deleted, instead of reloading and running
+// manyRuns again. The grid is updated in place and only the disks freed by
+// a deletion go through the greedy rule again.
+//
+// Commands, one per line:
+//   insert x y   -> id of the new point
+//   delete id    -> ok
+//   query id     -> 1 if the point is in the set, 0 otherwise
+//   size         -> size of the set
+//   save out.svg -> ok
+//   quit
+template <class Number>
+class DynamicSolver
+{
+    using Wide = typename Arithmetic<Number>::Wide;
+
+    double radius;
+    double cellSize;
+    Wide dist_max2;
+    Point<long long> dir; // Greedy rule of the local repairs
+
+    // Indexed by id, deleted ids are never reused
+    std::vector<Point<Number>> pts;
+    std::vector<uint8_t> present;
+    std::vector<uint8_t> chosen;
+    std::vector<int> cover; // Chosen disks overlapping the point, itself included
+    std::vector<int> slot;  // Position of the point in its cell
+
+    std::unordered_map<Cell, std::vector<int>, CellHash> grid;
+    std::size_t count = 0;
+
+    template <class F>
+    void forEachNear(const Point<Number> &p, F &&f) const
+    {
+        auto [cx, cy] = key_of(p, cellSize);
+        for (long long dx = -1; dx <= 1; ++dx)
+            for (long long dy = -1; dy <= 1; ++dy)
+            {
+                auto it = grid.find({cx + dx, cy + dy});
+                if (it == grid.end())
+                    continue;
+                for (int j : it->second)
+                    if (p.distance2(pts[j]) <= dist_max2)
+                        f(j);
+            }
+    }
+
+    void choose(int i)
+    {
+        chosen[i] = 1;
+        ++count;
+        forEachNear(pts[i], [&](int j) { cover[j]++; });
+    }
+
+    // Points that are not covered anymore are left in freed
+    void unchoose(int i, std::vector<int> &freed)
+    {
+        chosen[i] = 0;
+        --count;
+        forEachNear(pts[i], [&](int j) {
+            if (--cover[j] == 0 && j != i)
+                freed.push_back(j);
+        });
+    }
+
+    // Same rule as greedy, restricted to the freed points
+    void repair(std::vector<int> &freed)
+    {
+        auto proj = [&](int i) {
+            return Wide(pts[i].x) * dir.x + Wide(pts[i].y) * dir.y;
+        };
+        std::sort(freed.begin(), freed.end(), [&](int i, int j) {
+            return proj(i) > proj(j);
+        });
+        for (int i : freed)
+            if (present[i] && cover[i] == 0)
+                choose(i);
+    }
+
+    int add(Point<Number> p)
+    {
+        int id = (int) pts.size();
+        pts.push_back(p);
+        present.push_back(1);
+        chosen.push_back(0);
+        cover.push_back(0);
+
+        auto &cell = grid[key_of(p, cellSize)];
+        slot.push_back((int) cell.size());
+        cell.push_back(id);
+        return id;
+    }
+
+    static bool representable(double v)
+    {
+        if constexpr (std::is_integral_v<Number>)
+            if (std::fabs(v) >= (1 << 30)) // See exactWidth
+                return false;
+        return (double)(Number)v == v;
+    }
+
+public:
+    // Starts from a maximal independent set, like the ones greedy returns
+    DynamicSolver(const std::vector<Point<Number>> &initial, double _radius,
+                  const std::vector<int> &solution) :
+        radius(_radius),
+        cellSize(2 * _radius),
+        dist_max2(squaredDiameter<Wide>(_radius)),
+        dir(65536, 0)
+    {
+        for (const auto &p : initial)
+            add(p);
+        for (int i : solution)
+            choose(i);
+    }
+
+    // Returns the id of the new point, in the set if nothing overlaps it
+    int insert(Point<Number> p)
+    {
+        int id = add(p);
+        int covered = 0;
+        forEachNear(p, [&](int j) { covered += chosen[j]; });
+        cover[id] = covered;
+        if (covered == 0)
+            choose(id);
+        return id;
+    }
+
+    bool erase(int id)
+    {
+        if (id < 0 || id >= (int) pts.size() || !present[id])
+            return false;
+
+        std::vector<int> freed;
+        if (chosen[id])
+            unchoose(id, freed);
+
+        // Swap-remove from its cell
+        auto it = grid.find(key_of(pts[id], cellSize));
+        auto &cell = it->second;
+        int last = cell.back();
+        cell[slot[id]] = last;
+        slot[last] = slot[id];
+        cell.pop_back();
+        if (cell.empty())
+            grid.erase(it);
+        present[id] = 0;
+
+        repair(freed);
+        return true;
+    }
+
+    bool contains(int id) const
+    {
+        return id >= 0 && id < (int) pts.size() && present[id] && chosen[id];
+    }
+
+    std::size_t size() const { return count; }
+
+    void save(const std::string &fn, int others = 1) const
+    {
+        std::vector<Point<Number>> alive;
+        std::vector<int> solution;
+        for (std::size_t i = 0; i < pts.size(); ++i)
+        {
+            if (!present[i])
+                continue;
+            if (chosen[i])
+                solution.push_back((int) alive.size());
+            alive.push_back(pts[i]);
+        }
+        writeSolutionSVG(fn, alive, radius, solution, others);
+    }
+
+    void serve(std::istream &in, std::ostream &out)
+    {
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream args(line);
+            std::string cmd;
+            args >> cmd;
+
+            if (cmd == "insert")
+            {
+                double x, y;
+                if (!(args >> x >> y))
+                    out << "error: insert x y\n";
+                else if (!representable(x) || !representable(y))
+                    out << "error: coordinates out of range\n";
+                else
+                    out << insert(Point<Number>((Number)x, (Number)y)) << '\n';
+            }
+            else if (cmd == "delete")
+            {
+                int id;
+                if (!(args >> id) || !erase(id))
+                    out << "error: unknown id\n";
+                else
+                    out << "ok\n";
+            }
+            else if (cmd == "query")
+            {
+                int id;
+                if (!(args >> id))
+                    out << "error: query id\n";
+                else
+                    out << contains(id) << '\n';
+            }
+            else if (cmd == "size")
+                out << size() << '\n';
+            else if (cmd == "save")
+            {
+                std::string fn;
+                if (!(args >> fn))
+                    out << "error: save file.svg\n";
+                else
+                {
+                    save(fn);
+                    out << "ok\n";
+                }
+            }
+            else if (cmd == "quit")
+                break;
+            else if (!cmd.empty())
+                out << "error: unknown command " << cmd << '\n';
+
+            // Only flush once every pending command is answered
+            if (in.rdbuf()->in_avail() <= 0)
+                out.flush();
+        }
+        out.flush();
+    }
+};
+
+#endif
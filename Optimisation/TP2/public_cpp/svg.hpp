@@ -0,0 +1,240 @@
+// BERTOLINI Garice
+#ifndef SVG_HPP
+#define SVG_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <iostream>
+#include <vector>
+
+#include "point.hpp"
+
+// Buffered text writer for the solution pictures.
+// Everything is appended to one large reusable buffer that is only written
+// to the file when it is full, instead of flushing on every std::endl.
+class SvgWriter
+{
+    std::FILE *out;
+    std::string buf;
+    std::size_t used = 0;
+
+    static constexpr std::size_t capacity = 1 << 20; // 1 MiB
+    static constexpr std::size_t margin = 64;        // Room for one number
+
+    void flush()
+    {
+        std::fwrite(buf.data(), 1, used, out);
+        used = 0;
+    }
+
+    void reserve(std::size_t n)
+    {
+        if (used + n > capacity)
+            flush();
+    }
+
+public:
+    SvgWriter(const std::string &fn) :
+        out(std::fopen(fn.c_str(), "wb")),
+        buf(capacity, '\0')
+    {
+    }
+
+    ~SvgWriter()
+    {
+        if (out) {
+            flush();
+            std::fclose(out);
+        }
+    }
+
+    bool ok() const { return out != nullptr; }
+
+    SvgWriter &operator<<(std::string_view s)
+    {
+        if (s.size() > capacity) { // Would never fit, write it through
+            flush();
+            std::fwrite(s.data(), 1, s.size(), out);
+            return *this;
+        }
+        reserve(s.size());
+        s.copy(buf.data() + used, s.size());
+        used += s.size();
+        return *this;
+    }
+
+    SvgWriter &operator<<(char c)
+    {
+        reserve(1);
+        buf[used++] = c;
+        return *this;
+    }
+
+    // Numbers are formatted with std::to_chars, floating points with the
+    // same "%g" 6 digits format std::ostream uses by default
+    template <class T>
+        requires std::is_arithmetic_v<T>
+    SvgWriter &operator<<(T value)
+    {
+        reserve(margin);
+        char *first = buf.data() + used;
+        std::to_chars_result res;
+        if constexpr (std::is_floating_point_v<T>)
+            res = std::to_chars(first, first + margin, value,
+                                std::chars_format::general, 6);
+        else
+            res = std::to_chars(first, first + margin, value);
+        used += res.ptr - first;
+        return *this;
+    }
+};
+
+// Picture of a solution drawn disk by disk, once the bounding box of the
+// centers is known. The file is closed when the picture is destroyed.
+class SolutionPicture
+{
+    SvgWriter fsvg;
+    double x0, y1, input_size, image_radius;
+    int image_size;
+
+    Point<double> inputToImagePt(Point<double> p) const
+    {
+        Point<double> q((p.x - x0) * image_size / input_size,
+                        (y1 - p.y) * image_size / input_size);
+        return q;
+    }
+
+public:
+    SolutionPicture(const std::string &fn, double minx, double miny,
+                    double maxx, double maxy, double radius,
+                    int _image_size = 1000) :
+        fsvg(fn),
+        image_size(_image_size)
+    {
+        x0 = minx - radius;
+        double y0 = miny - radius;
+        double x1 = maxx + radius;
+        y1 = maxy + radius;
+        input_size = std::max(x1 - x0, y1 - y0);
+        image_radius = (double)image_size * radius / input_size;
+
+        if (!fsvg.ok())
+        {
+            std::cerr << "Error writing " << fn << std::endl;
+            return;
+        }
+
+        fsvg << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+        Point<double> image_size_xy = inputToImagePt(Point{x1, y0});
+        fsvg << "<svg xmlns=\"http://www.w3.org/2000/svg\""
+             << " version=\"1.1\" width=\""
+             << image_size_xy.x
+             << "\" height=\""
+             << image_size_xy.y
+             << "\">\n";
+    }
+
+    ~SolutionPicture()
+    {
+        if (fsvg.ok())
+            fsvg << "</svg>\n";
+    }
+
+    bool ok() const { return fsvg.ok(); }
+
+    template <class Number>
+    void circle(const Point<Number> &input_p, std::string_view color)
+    {
+        draw(input_p, color, image_radius);
+    }
+
+    // Disk with its own radius, for instances with per-point radii
+    template <class Number>
+    void circle(const Point<Number> &input_p, std::string_view color, double radius)
+    {
+        draw(input_p, color, (double)image_size * radius / input_size);
+    }
+
+private:
+    template <class Number>
+    void draw(const Point<Number> &input_p, std::string_view color, double r)
+    {
+        Point<double> image_p = inputToImagePt({(double)input_p.x, (double)input_p.y});
+        fsvg << " <circle"
+             << " stroke=\"" << color << "\""
+             << " fill=\"none\""
+             << " stroke-width=\"2\""
+             << " cx=\"" << image_p.x << "\""
+             << " cy=\"" << image_p.y << "\""
+             << " r=\"" << r << "\""
+             << ">\n";
+
+        fsvg << "  <title>"
+             << "(" << input_p.x << "," << input_p.y << ")"
+             << "</title>\n";
+
+        fsvg << " </circle>\n";
+    }
+};
+
+// Draws every disk, the solution in blue. On huge instances, only one
+// non-solution disk out of `others` is drawn (0 draws none of them).
+// When radii is not empty, each disk is drawn with its own radius.
+template <class Number>
+void writeSolutionSVG(const std::string &fn, const std::vector<Point<Number>> &pts,
+                      double radius, const std::vector<int> &solution,
+                      int others = 1, int image_size = 1000,
+                      const std::vector<double> &radii = {})
+{
+    if (pts.empty())
+        return;
+
+    // Bounding box in one pass
+    double x0 = pts[0].x, y0 = pts[0].y, x1 = pts[0].x, y1 = pts[0].y;
+    for (const auto &p : pts)
+    {
+        x0 = std::min<double>(x0, p.x);
+        y0 = std::min<double>(y0, p.y);
+        x1 = std::max<double>(x1, p.x);
+        y1 = std::max<double>(y1, p.y);
+    }
+
+    if (!radii.empty())
+        radius = *std::max_element(radii.begin(), radii.end());
+
+    SolutionPicture picture(fn, x0, y0, x1, y1, radius, image_size);
+    if (!picture.ok())
+        return;
+
+    // Solution membership from the indices : O(n + k)
+    std::vector<bool> inSolution(pts.size(), false);
+    for (int i : solution)
+        inSolution[i] = true;
+
+    if (others > 0)
+    {
+        int seen = 0;
+        int ptsSize = (int) pts.size();
+        for (int i = 0; i < ptsSize; ++i)
+        {
+            if (inSolution[i] || seen++ % others != 0)
+                continue;
+            if (radii.empty())
+                picture.circle(pts[i], "black");
+            else
+                picture.circle(pts[i], "black", radii[i]);
+        }
+    }
+
+    for (int i : solution)
+        if (radii.empty())
+            picture.circle(pts[i], "blue");
+        else
+            picture.circle(pts[i], "blue", radii[i]);
+}
+
+#endif
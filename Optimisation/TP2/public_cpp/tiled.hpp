@@ -0,0 +1,410 @@
+// BERTOLINI Garice
+#ifndef TILED_HPP
+#define TILED_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "index.hpp"
+#include "loader.hpp"
+#include "point.hpp"
+#include "svg.hpp"
+
+// Out-of-core pipeline for instances larger than memory.
+//  1. The input is streamed once, its points are bucketed by tile into
+//     binary files. A tile is `cells` grid cells of 2 * radius wide.
+//  2. Tiles are solved in 4 phases, by parity of their coordinates, so the
+//     tiles of a phase are a whole tile apart and run in parallel. The disks
+//     already chosen by the neighbouring tiles (the 2 * radius halo) are
+//     fixed before greedy runs: no two chosen disks overlap across edges.
+//  3. The picture is drawn tile by tile.
+// At most `budget` points are loaded at once, by all the workers together.
+
+struct TiledOptions
+{
+    std::string dir;              // Where the tile files go
+    double cells = 64;            // Side of a tile, in 2 * radius cells
+    std::size_t budget = 1 << 22; // Points loaded at once
+    unsigned threads = 0;
+};
+
+// Disk chosen in a tile, with its rank in the tile file
+struct Chosen
+{
+    double x, y;
+    uint32_t index;
+};
+
+class TileStore
+{
+    struct Tile
+    {
+        std::size_t count = 0;
+        std::vector<double> buffer; // x0, y0, x1, y1...
+        std::FILE *file = nullptr;  // Open while among the recent ones
+        bool written = false;       // Whether this run wrote the file yet
+        std::size_t lastUse = 0;
+    };
+
+    // Points buffered per tile, and by all tiles: reaching it flushes them
+    // all, so memory does not grow with the number of tiles. At most
+    // openFiles tile files stay open, the least recently used is closed.
+    static constexpr std::size_t bufferPoints = 512;
+    static constexpr std::size_t maxBuffered = 1 << 20;
+    static constexpr std::size_t openFiles = 64;
+
+    std::string dir, prefix;
+    double side;
+    std::unordered_map<Cell, Tile, CellHash> tiles;
+    std::vector<Tile *> open;
+    std::size_t buffered = 0, uses = 0;
+
+    // The first flush of a run truncates the file: files left by a killed
+    // run in the same directory are not appended to
+    void flush(const Cell &c, Tile &tile)
+    {
+        if (tile.buffer.empty())
+            return;
+        if (!tile.file)
+        {
+            if (open.size() == openFiles)
+            {
+                auto lru = std::min_element(open.begin(), open.end(), [](Tile *a, Tile *b) {
+                    return a->lastUse < b->lastUse;
+                });
+                std::fclose((*lru)->file);
+                (*lru)->file = nullptr;
+                *lru = open.back();
+                open.pop_back();
+            }
+            tile.file = std::fopen(path(c, "pts").c_str(), tile.written ? "ab" : "wb");
+            if (!tile.file)
+                loadError(path(c, "pts"), "cannot write tile");
+            tile.written = true;
+            open.push_back(&tile);
+        }
+        tile.lastUse = ++uses;
+        std::fwrite(tile.buffer.data(), sizeof(double), tile.buffer.size(), tile.file);
+        buffered -= tile.buffer.size() / 2;
+        tile.buffer = {};
+    }
+
+    void closeFiles()
+    {
+        for (Tile *tile : open)
+        {
+            std::fclose(tile->file);
+            tile->file = nullptr;
+        }
+        open.clear();
+    }
+
+public:
+    TileStore(const std::string &_dir, double _side, const std::string &_prefix = "") :
+        dir(_dir),
+        prefix(_prefix),
+        side(_side)
+    {
+    }
+
+    double tileSide() const { return side; }
+    const std::unordered_map<Cell, Tile, CellHash> &all() const { return tiles; }
+
+    std::string path(const Cell &c, const char *ext) const
+    {
+        return dir + "/" + prefix + std::to_string(c.x) + "_" + std::to_string(c.y) + "." + ext;
+    }
+
+    Cell tileOf(double x, double y) const
+    {
+        return key_of(Point<double>(x, y), side);
+    }
+
+    void add(double x, double y)
+    {
+        Cell c = tileOf(x, y);
+        Tile &tile = tiles[c];
+        tile.buffer.push_back(x);
+        tile.buffer.push_back(y);
+        tile.count++;
+        buffered++;
+        if (tile.buffer.size() >= 2 * bufferPoints)
+            flush(c, tile);
+        else if (buffered >= maxBuffered)
+            for (auto &[other, t] : tiles)
+                flush(other, t);
+    }
+
+    // Writes what is left, the files can be read from then on
+    void finish()
+    {
+        for (auto &[c, tile] : tiles)
+            flush(c, tile);
+        closeFiles();
+    }
+
+    // Whole content of a tile file
+    template <class T>
+    std::vector<T> read(const Cell &c, const char *ext) const
+    {
+        std::vector<T> ret;
+        std::FILE *f = std::fopen(path(c, ext).c_str(), "rb");
+        if (!f)
+            return ret;
+        std::fseek(f, 0, SEEK_END);
+        ret.resize(std::ftell(f) / sizeof(T));
+        std::fseek(f, 0, SEEK_SET);
+        if (std::fread(ret.data(), sizeof(T), ret.size(), f) != ret.size())
+            ret.clear();
+        std::fclose(f);
+        return ret;
+    }
+
+    // Calls f(x, y) for every point of a tile, reading it by chunks
+    template <class F>
+    void forEachPoint(const Cell &c, F &&f) const
+    {
+        std::FILE *in = std::fopen(path(c, "pts").c_str(), "rb");
+        if (!in)
+            return;
+        std::vector<double> chunk(2 * 65536);
+        std::size_t got;
+        while ((got = std::fread(chunk.data(), sizeof(double), chunk.size(), in)) > 0)
+            for (std::size_t k = 0; k + 1 < got; k += 2)
+                f(chunk[k], chunk[k + 1]);
+        std::fclose(in);
+    }
+
+    void removeFiles() const
+    {
+        for (const auto &[c, tile] : tiles)
+        {
+            std::remove(path(c, "pts").c_str());
+            std::remove(path(c, "sol").c_str());
+        }
+    }
+};
+
+// Instance bucketed into tile files by tileInstance
+struct TiledInstance
+{
+    TileStore store;
+    double radius = 0;
+    std::size_t count = 0;
+    double minx = 0, miny = 0, maxx = 0, maxy = 0;
+    Width width = Width::Int32;
+};
+
+// Streams the input into tile files, in constant memory. Points read before
+// the radius are spilled to a single file and bucketed once it is known.
+inline TiledInstance tileInstance(const std::string &fn, const TiledOptions &opts)
+{
+    std::filesystem::create_directories(opts.dir);
+
+    std::optional<TileStore> store;
+    TileStore spill(opts.dir, INFINITY, "spill");
+    TiledInstance tiled{TileStore(opts.dir, 0)};
+    WidthCheck check;
+    bool hasRadius = false;
+
+    streamInstance(fn,
+        [&](double r) {
+            tiled.radius = r;
+            hasRadius = true;
+            if (r > 0)
+                store.emplace(opts.dir, std::max(opts.cells, 2.0) * 2 * r);
+        },
+        [&](double x, double y) {
+            if (tiled.count++ == 0)
+            {
+                tiled.minx = tiled.maxx = x;
+                tiled.miny = tiled.maxy = y;
+            }
+            tiled.minx = std::min(tiled.minx, x);
+            tiled.miny = std::min(tiled.miny, y);
+            tiled.maxx = std::max(tiled.maxx, x);
+            tiled.maxy = std::max(tiled.maxy, y);
+            check.account(x);
+            check.account(y);
+            if (store)
+                store->add(x, y);
+            else
+                spill.add(x, y);
+        });
+
+    if (!hasRadius)
+        loadError(fn, "missing \"radius\"");
+    if (!store) // Tiles would be empty
+        loadError(fn, "tiling needs a positive radius");
+
+    spill.finish();
+    for (const auto &[c, tile] : spill.all())
+        spill.forEachPoint(c, [&](double x, double y) { store->add(x, y); });
+    spill.removeFiles();
+    store->finish();
+
+    tiled.store = std::move(*store);
+    tiled.width = check.result();
+    return tiled;
+}
+
+// Solves the tiles in 4 phases and returns the solution size.
+// solve(inst, fixed) returns the chosen points of one tile, given the
+// halo points (the indices in fixed) that must not be overlapped.
+template <class Solve>
+std::size_t solveTiled(const TileStore &store, double radius,
+                       const TiledOptions &opts, Solve &&solve)
+{
+    auto phaseOf = [](const Cell &c) {
+        return (int)(((c.x % 2) + 2) % 2) * 2 + (int)(((c.y % 2) + 2) % 2);
+    };
+
+    unsigned threads = opts.threads ? opts.threads
+                                    : std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<std::size_t> total = 0;
+
+    // Memory budget shared by the workers, one tile always gets through
+    std::mutex mutex;
+    std::condition_variable released;
+    std::size_t inUse = 0;
+
+    auto solveTile = [&](const Cell &c, int phase)
+    {
+        std::vector<double> own = store.read<double>(c, "pts");
+        std::size_t n = own.size() / 2;
+
+        Instance inst;
+        inst.radius = radius;
+        inst.x.reserve(n);
+        inst.y.reserve(n);
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            inst.x.push_back(own[2 * k]);
+            inst.y.push_back(own[2 * k + 1]);
+        }
+        own = {};
+
+        // Halo: disks chosen by the neighbours of earlier phases that are
+        // within 2 * radius of the tile
+        double side = store.tileSide();
+        double x0 = c.x * side - 2 * radius, x1 = (c.x + 1) * side + 2 * radius;
+        double y0 = c.y * side - 2 * radius, y1 = (c.y + 1) * side + 2 * radius;
+        std::vector<int> fixed;
+        for (long long dx = -1; dx <= 1; ++dx)
+            for (long long dy = -1; dy <= 1; ++dy)
+            {
+                Cell neighbour{c.x + dx, c.y + dy};
+                if (phaseOf(neighbour) >= phase || !store.all().contains(neighbour))
+                    continue;
+                for (const Chosen &d : store.read<Chosen>(neighbour, "sol"))
+                {
+                    if (d.x < x0 || d.x > x1 || d.y < y0 || d.y > y1)
+                        continue;
+                    fixed.push_back((int) inst.size());
+                    inst.x.push_back(d.x);
+                    inst.y.push_back(d.y);
+                }
+            }
+
+        std::vector<int> solution = solve(inst, std::move(fixed));
+
+        std::FILE *f = std::fopen(store.path(c, "sol").c_str(), "wb");
+        if (!f)
+            loadError(store.path(c, "sol"), "cannot write tile solution");
+        for (int i : solution)
+        {
+            Chosen d{inst.x[i], inst.y[i], (uint32_t)i};
+            std::fwrite(&d, sizeof(d), 1, f);
+        }
+        std::fclose(f);
+        return solution.size();
+    };
+
+    for (int phase = 0; phase < 4; ++phase)
+    {
+        std::vector<Cell> todo;
+        for (const auto &[c, tile] : store.all())
+            if (phaseOf(c) == phase)
+                todo.push_back(c);
+
+        std::atomic<std::size_t> next = 0;
+        auto worker = [&]()
+        {
+            for (std::size_t k; (k = next++) < todo.size();)
+            {
+                const Cell &c = todo[k];
+                std::size_t need = store.all().at(c).count;
+                if (need > opts.budget)
+                    std::cerr << "Warning: a tile of " << need
+                              << " points is over budget, use a smaller --tile-size" << std::endl;
+                {
+                    std::unique_lock lock(mutex);
+                    released.wait(lock, [&] { return inUse == 0 || inUse + need <= opts.budget; });
+                    inUse += need;
+                }
+
+                total += solveTile(c, phase);
+
+                {
+                    std::lock_guard lock(mutex);
+                    inUse -= need;
+                }
+                released.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < threads; ++t)
+            workers.emplace_back(worker);
+        worker();
+        for (auto &w : workers)
+            w.join();
+    }
+
+    return total;
+}
+
+// Draws the tiles one by one, all the black disks first.
+// Titles show the coordinates as Number, like writeSolutionSVG does.
+template <class Number>
+void writeTiledSVG(const std::string &fn, const TileStore &store,
+                          double radius, double minx, double miny,
+                          double maxx, double maxy, int others = 1)
+{
+    SolutionPicture picture(fn, minx, miny, maxx, maxy, radius);
+    if (!picture.ok())
+        return;
+
+    if (others > 0)
+    {
+        int seen = 0;
+        for (const auto &[c, tile] : store.all())
+        {
+            std::vector<bool> inSolution(tile.count, false);
+            for (const Chosen &d : store.read<Chosen>(c, "sol"))
+                inSolution[d.index] = true;
+
+            std::size_t k = 0;
+            store.forEachPoint(c, [&](double x, double y) {
+                if (!inSolution[k++] && seen++ % others == 0)
+                    picture.circle(Point<Number>((Number)x, (Number)y), "black");
+            });
+        }
+    }
+
+    for (const auto &[c, tile] : store.all())
+        for (const Chosen &d : store.read<Chosen>(c, "sol"))
+            picture.circle(Point<Number>((Number)d.x, (Number)d.y), "blue");
+}
+
+#endif
@@ -1,10 +1,11 @@
 #!/bin/bash
 
-g++ -Wall -std=c++20 -Ofast -o main main.cpp
+g++ -Wall -std=c++20 -Ofast -pthread -o main main.cpp
+g++ -Wall -std=c++20 -Ofast -pthread -o verify verify.cpp
 
 for a in ../instances/*.edges
 do
   time ./main $a
-  python3 testdom.py $a ${a%.edges}.dom
+  ./verify $a ${a%.edges}.dom
 done
 
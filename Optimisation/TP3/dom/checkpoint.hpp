@@ -0,0 +1,92 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "graph.hpp"
+#include "tools.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Set by SIGINT and SIGTERM: the workers stop and the best solution is
+// saved as at the end of a normal run. A second signal kills the process.
+inline std::atomic<bool> interrupted = false;
+
+inline void stop_on_signals() {
+  auto handler = [](int sig) {
+    interrupted = true;
+    std::signal(sig, SIG_DFL);
+  };
+  std::signal(SIGINT, handler);
+  std::signal(SIGTERM, handler);
+}
+
+// Writes the solution with the vertex ids of the input. The file is written
+// next to its destination and renamed over it, so a kill never leaves a
+// truncated solution behind
+template<class Vertex>
+bool write_solution(const std::string &outfn, const std::vector<int> &solution, const Graph<Vertex> &g) {
+  std::string tmp = outfn + ".tmp";
+  {
+    std::ofstream outfile(tmp);
+    for(int v : solution) {
+      outfile << g.label(v) << '\n';
+    }
+    if(!outfile.flush())
+      return false;
+  }
+  return std::rename(tmp.c_str(), outfn.c_str()) == 0;
+}
+
+// Solution saved by an earlier run, vertices unknown to g are dropped.
+// Empty when the file cannot be read or has no vertex of g
+template<class Vertex>
+std::optional<std::vector<int>> read_solution(const std::string &fn, const Graph<Vertex> &g) {
+  std::vector<int> ret;
+  std::ifstream infile(fn);
+  Vertex v;
+  while(infile >> v) {
+    int id = g.id(v);
+    if(id >= 0)
+      ret.push_back(id);
+  }
+  if(ret.empty())
+    return std::nullopt;
+  return ret;
+}
+
+// Writes the best solution while the search runs, at most once every
+// `every` seconds
+template<class Vertex>
+class Checkpoint {
+  const Graph<Vertex> &g;
+  std::string outfn;
+  double every;
+  std::atomic<double> last;
+  std::mutex writing;
+
+public:
+  Checkpoint(const Graph<Vertex> &_g, const std::string &_outfn, double _every = 1) :
+    g(_g), outfn(_outfn), every(_every), last(-_every) {
+  }
+
+  // Whether a write would happen now
+  bool due() const {
+    return elapsed() - last >= every;
+  }
+
+  // Writes the solution if due, and if no other thread is writing
+  void offer(const std::vector<int> &solution) {
+    std::unique_lock lock(writing, std::try_to_lock);
+    if(!lock || !due())
+      return;
+    last = elapsed();
+    write_solution(outfn, solution, g);
+  }
+};
+
+#endif
@@ -1,134 +1,423 @@
 #ifndef GRAPH_HPP
 #define GRAPH_HPP
 
+#include "../../common/radixsort.hpp"
 #include <fstream>
-#include <unordered_map>
-#include <unordered_set>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <queue>
 #include <cassert>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+// Calls f(t, threads) on threads threads, f(0, threads) on the caller's
+template<class F>
+void parallel(unsigned threads, F &&f) {
+  std::vector<std::thread> workers;
+  for(unsigned t = 1; t < threads; t++)
+    workers.emplace_back(f, t, threads);
+  f(0, threads);
+  for(auto &w : workers)
+    w.join();
+}
+
+// Pairs of integers of an edge file, in file order. The file is mapped in
+// memory and cut at line boundaries into one slice per thread, each parsed
+// by a plain digit scanner. Lines that do not start with a number are
+// skipped, and only the first two numbers of a line are read
+template<class Vertex>
+std::vector<std::pair<Vertex,Vertex>> readEdges(const std::string &filename) {
+  std::vector<std::pair<Vertex,Vertex>> ret;
+  if constexpr(!std::is_integral_v<Vertex>) {
+    std::ifstream infile(filename);
+    Vertex u,v;
+    while(infile >> u >> v)
+      ret.emplace_back(u, v);
+    return ret;
+  }
+  else {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+      if(fd >= 0)
+        close(fd);
+      return ret;
+    }
+    std::size_t size = st.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED)
+      return ret;
+    madvise(map, size, MADV_SEQUENTIAL);
+    const char *data = (const char *) map;
+
+    // About 4MB per thread
+    unsigned threads = std::clamp<std::size_t>(size >> 22, 1, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::size_t> cut(threads + 1, size);
+    cut[0] = 0;
+    for(unsigned t = 1; t < threads; t++) {
+      const char *nl = (const char *) std::memchr(data + size / threads * t, '\n', size - size / threads * t);
+      cut[t] = nl ? nl - data + 1 : size;
+    }
+
+    std::vector<std::vector<std::pair<Vertex,Vertex>>> parts(threads);
+    parallel(threads, [&](unsigned t, unsigned) {
+      const char *p = data + cut[t], *end = data + std::max(cut[t], cut[t + 1]);
+      auto &out = parts[t];
+      out.reserve((end - p) / 16);
+      auto digit = [](char c) { return (unsigned) (c - '0') <= 9; };
+      while(p < end) {
+        // Only the lines that start with a number are edges: comments and
+        // headers are skipped, whatever digits they contain
+        while(p < end && (*p == ' ' || *p == '\t'))
+          p++;
+        Vertex x[2] = {0, 0};
+        int found = 0;
+        if(p < end && (digit(*p) || *p == '-')) {
+          for(; found < 2; found++) {
+            while(p < end && *p != '\n' && *p != '-' && !digit(*p))
+              p++;
+            if(p == end || *p == '\n')
+              break;
+            bool negative = *p == '-';
+            p += negative;
+            for(; p < end && digit(*p); p++)
+              x[found] = x[found] * 10 + (*p - '0');
+            if(negative)
+              x[found] = -x[found];
+          }
+        }
+        if(found == 2)
+          out.emplace_back(x[0], x[1]);
+        const char *nl = (const char *) std::memchr(p, '\n', end - p);
+        p = nl ? nl + 1 : end;
+      }
+    });
+    munmap(map, size);
+
+    std::size_t total = 0;
+    for(auto &part : parts)
+      total += part.size();
+    ret.reserve(total);
+    for(auto &part : parts) {
+      ret.insert(ret.end(), part.begin(), part.end());
+      part = {};
+    }
+    return ret;
+  }
+}
+
+// Neighbors of a vertex, either a slice of the CSR arrays or computed into
+// a small buffer by the grid backend
+class Neighbors {
+  const int *first = nullptr, *last = nullptr;
+  std::array<int, 8> buffer;
+  int count = 0;
+
+public:
+  Neighbors(const int *_first, const int *_last) : first(_first), last(_last) {
+  }
+
+  Neighbors() {
+  }
+
+  void push_back(int v) {
+    buffer[count++] = v;
+  }
+
+  const int *begin() const { return first ? first : buffer.data(); }
+  const int *end() const { return first ? last : buffer.data() + count; }
+  std::size_t size() const { return end() - begin(); }
+};
+
+// Read-only graph. Vertices are relabeled 0..n-1 at load time and the
+// adjacency is stored in one of two backends:
+//  - Grid: when every edge joins two cells of the grid encoding of the ids
+//    (v = x * gridBase + y, as testdom.py draws them) that touch, including
+//    diagonally, and the occupied cells fill enough of their bounding box.
+//    A bitmap of occupied cells and a mask of the 8 grid directions per
+//    vertex, neighbors are computed arithmetically. Vertices are numbered
+//    in cell order.
+//  - CSR: sorted neighbor arrays, vertices numbered in increasing id order,
+//    which keeps the grid encoded neighbors close.
+// An edge from a vertex to itself keeps the vertex, but is not one of its
+// neighbors: it is listed by loops() instead.
+// Vertex is the type of the ids in the file, given back by label(v).
 template<class Vertex>
 class Graph {
-  std::unordered_map<Vertex, std::unordered_set<Vertex>> adj;
-  
+  static constexpr long long gridBase = 100000;
+  static constexpr int dx[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+  static constexpr int dy[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+
+  int n = 0;
+  std::size_t edges = 0;
+  std::vector<int> selfLoops; // Sorted vertices with an edge to themselves
+
+  // CSR backend
+  std::vector<Vertex> labels;     // Dense id -> id in the file
+  std::vector<std::size_t> start; // Neighbors of v are adj[start[v]..start[v+1])
+  std::vector<int> adj;
+
+  // Grid backend, cells are numbered column by column in the bounding box
+  bool grid = false;
+  long long minx = 0, miny = 0, height = 0;
+  std::vector<uint64_t> occupied;  // Bitmap of the cells
+  std::vector<uint32_t> before;    // Occupied cells in the previous words
+  std::vector<uint32_t> cells;     // Dense id -> cell
+  std::vector<uint8_t> directions; // Bit d when the edge towards dx[d], dy[d] exists
+
+  // Dense id of an occupied cell
+  int rank(long long c) const {
+    uint64_t below = occupied[c >> 6] & ((uint64_t(1) << (c & 63)) - 1);
+    return before[c >> 6] + std::popcount(below);
+  }
+
+  // Builds the grid backend if the edges allow it
+  bool loadGrid(const std::vector<std::pair<Vertex,Vertex>> &raw) {
+    if constexpr(!std::is_integral_v<Vertex>) {
+      return false;
+    }
+    else {
+      if(raw.empty())
+        return false;
+      auto x = [](Vertex v) { return (long long) v / gridBase; };
+      auto y = [](Vertex v) { return (long long) v % gridBase; };
+
+      long long maxx = x(raw[0].first), maxy = y(raw[0].first);
+      minx = maxx;
+      miny = maxy;
+      for(auto [u, v] : raw) {
+        if(u < 0 || v < 0 || std::abs(x(u) - x(v)) > 1 || std::abs(y(u) - y(v)) > 1)
+          return false;
+        minx = std::min({minx, x(u), x(v)});
+        maxx = std::max({maxx, x(u), x(v)});
+        miny = std::min({miny, y(u), y(v)});
+        maxy = std::max({maxy, y(u), y(v)});
+      }
+
+      // The bitmap and its ranks cost 1.5 bits per cell: at most 16 cells
+      // per edge keeps it to a few bytes per vertex
+      height = maxy - miny + 1;
+      long long area = (maxx - minx + 1) * height;
+      if(area > 16 * (long long) raw.size() + 4096 || area >= (1ll << 32))
+        return false;
+
+      auto cell = [&](Vertex v) { return (x(v) - minx) * height + (y(v) - miny); };
+      occupied.assign(area / 64 + 1, 0);
+      for(auto [u, v] : raw) {
+        occupied[cell(u) >> 6] |= uint64_t(1) << (cell(u) & 63);
+        occupied[cell(v) >> 6] |= uint64_t(1) << (cell(v) & 63);
+      }
+      before.resize(occupied.size());
+      for(std::size_t k = 0; k < occupied.size(); k++) {
+        before[k] = n;
+        for(uint64_t w = occupied[k]; w; w &= w - 1)
+          cells.push_back(k * 64 + std::countr_zero(w));
+        n += std::popcount(occupied[k]);
+      }
+
+      directions.assign(n, 0);
+      for(auto [u, v] : raw) {
+        if(u == v)
+          selfLoops.push_back(rank(cell(u)));
+        for(int d = 0; d < 8; d++) {
+          if(x(v) - x(u) == dx[d] && y(v) - y(u) == dy[d]) {
+            directions[rank(cell(u))] |= 1 << d;
+            directions[rank(cell(v))] |= 1 << (7 - d); // dx[7-d] = -dx[d]
+          }
+        }
+      }
+      std::sort(selfLoops.begin(), selfLoops.end());
+      selfLoops.erase(std::unique(selfLoops.begin(), selfLoops.end()), selfLoops.end());
+      for(uint8_t m : directions)
+        edges += std::popcount(m);
+      edges /= 2;
+      grid = true;
+      return true;
+    }
+  }
+
+  void loadCSR(const std::vector<std::pair<Vertex,Vertex>> &raw) {
+    // Endpoints sorted by id, which numbers them in one pass. Endpoint
+    // 2k is the first one of raw[k], 2k+1 the second one
+    auto endpoint = [&](std::size_t e) {
+      return e & 1 ? raw[e >> 1].second : raw[e >> 1].first;
+    };
+    std::vector<uint32_t> order(2 * raw.size());
+    for(std::size_t e = 0; e < order.size(); e++)
+      order[e] = e;
+    radixSort(order, endpoint);
+
+    std::vector<int> id(order.size());
+    for(uint32_t e : order) {
+      Vertex v = endpoint(e);
+      if(labels.empty() || labels.back() != v)
+        labels.push_back(v);
+      id[e] = labels.size() - 1;
+    }
+    order = {};
+    labels.shrink_to_fit();
+    n = labels.size();
+
+    // Counting sort of both directions of every edge, the loops apart
+    start.assign(n + 1, 0);
+    for(std::size_t e = 0; e < id.size(); e += 2) {
+      if(id[e] != id[e + 1]) {
+        start[id[e] + 1]++;
+        start[id[e + 1] + 1]++;
+      }
+      else
+        selfLoops.push_back(id[e]);
+    }
+    std::sort(selfLoops.begin(), selfLoops.end());
+    selfLoops.erase(std::unique(selfLoops.begin(), selfLoops.end()), selfLoops.end());
+    for(int k = 0; k < n; k++)
+      start[k + 1] += start[k];
+    adj.resize(start[n]);
+    std::vector<std::size_t> next(start.begin(), start.end() - 1);
+    for(std::size_t e = 0; e < id.size(); e += 2) {
+      if(id[e] != id[e + 1]) {
+        adj[next[id[e]]++] = id[e + 1];
+        adj[next[id[e + 1]]++] = id[e];
+      }
+    }
+    id = {};
+
+    // Sorted lists, duplicates removed in place
+    std::size_t kept = 0;
+    for(int v = 0; v < n; v++) {
+      auto first = adj.begin() + start[v], last = adj.begin() + start[v + 1];
+      std::sort(first, last);
+      last = std::unique(first, last);
+      // Nothing to move until a duplicate was removed, and the ranges
+      // would overlap
+      if(kept != start[v])
+        std::copy(first, last, adj.begin() + kept);
+      start[v] = kept;
+      kept += last - first;
+    }
+    start[n] = kept;
+    adj.resize(kept);
+    adj.shrink_to_fit();
+    edges = adj.size() / 2;
+  }
+
 public:
-  Graph() {
-  }  
-  void addVertex(Vertex v) {
-    adj[v];
+  Graph() : start(1, 0) {
   }
-  
+
   Graph(std::string filename) {
-    std::ifstream infile(filename);
-    Vertex u,v;
-    while(infile >> u >> v) {
-      addEdge(u,v);
-    }
+    std::vector<std::pair<Vertex,Vertex>> raw = readEdges<Vertex>(filename);
+    if(!loadGrid(raw))
+      loadCSR(raw);
+  }
+
+  bool isGrid() const {
+    return grid;
+  }
+
+  Vertex label(int v) const {
+    if(!grid)
+      return labels[v];
+    long long c = cells[v];
+    return (Vertex) ((minx + c / height) * gridBase + miny + c % height);
   }
 
-  void addEdge(Vertex u, Vertex v) {
-    if(u != v) {
-      adj[u].insert(v);
-      adj[v].insert(u);
+  // Dense id of the vertex with this id in the file, -1 if there is none
+  int id(Vertex label) const {
+    if(!grid) {
+      auto it = std::lower_bound(labels.begin(), labels.end(), label);
+      return it != labels.end() && *it == label ? it - labels.begin() : -1;
     }
+    long long x = (long long) label / gridBase - minx, y = (long long) label % gridBase - miny;
+    long long c = x * height + y;
+    if(label < 0 || x < 0 || y < 0 || y >= height || c >= (long long) occupied.size() * 64 ||
+       !(occupied[c >> 6] >> (c & 63) & 1))
+      return -1;
+    return rank(c);
   }
-  
-  bool containsVertex(Vertex v) const {
-    return adj.count(v) != 0;
+
+  bool containsVertex(int v) const {
+    return v >= 0 && v < countVertices();
   }
-  
-  bool containsEdge(Vertex u, Vertex v) const {
-    return containsVertex(u) && adj.at(u).count(v) != 0;
+
+  bool containsEdge(int u, int v) const {
+    if(!containsVertex(u))
+      return false;
+    auto nu = neighbors(u);
+    return std::binary_search(nu.begin(), nu.end(), v);
   }
-  
-  int degree(Vertex v) const {
-    return containsVertex(v) ? adj.at(v).size() : -1;
+
+  int degree(int v) const {
+    if(!containsVertex(v))
+      return -1;
+    return grid ? std::popcount(directions[v]) : start[v + 1] - start[v];
   }
-  
+
   int maxDegree() const {
     int ret = -1;
-    for(const auto &[v, neigh] : adj) {
-      ret = std::max(ret,(int)neigh.size());
+    for(int v = 0; v < countVertices(); v++) {
+      ret = std::max(ret, degree(v));
     }
-    
+
     return ret;
   }
-  
+
   int countVertices() const {
-    return adj.size();
+    return n;
   }
-  
+
   int countEdges() const {
-    int ret = 0;
-    for(const auto &[v, neigh] : adj) {
-      ret += neigh.size();
-    }
-    assert(ret % 2 == 0);
-    return ret / 2;
-  }
-  
-  void removeEdge(Vertex u, Vertex v) {
-    if(containsEdge(u,v)) {
-      adj.at(u).erase(v);
-      adj.at(v).erase(u);
-    }
-  }
-  
-  void removeVertex(Vertex v) {
-    if(containsVertex(v)) {
-      std::unordered_set<Vertex> neigh(adj.at(v)); // Copy because changing the data structure invalidades the iterator
-      for(Vertex u : neigh) {
-        removeEdge(u,v);
-      }
-      adj.erase(v);
-    }
+    return edges;
   }
 
-  void clear() {
-    adj.clear();
+  // Vertices with an edge to themselves, in increasing order
+  const std::vector<int> &loops() const {
+    return selfLoops;
   }
-  
-  std::unordered_set<Vertex> vertices() const {
-    std::unordered_set<Vertex> ret;
-    for(const auto &[v, neigh] : adj) {
-      ret.insert(v);
+
+  // Sorted neighbors of v, never v itself
+  Neighbors neighbors(int v) const {
+    if(!grid)
+      return {adj.data() + start[v], adj.data() + start[v + 1]};
+
+    // Directions are in increasing cell order, so are the ranks
+    Neighbors ret;
+    for(unsigned m = directions[v]; m; m &= m - 1) {
+      int d = std::countr_zero(m);
+      ret.push_back(rank(cells[v] + dx[d] * height + dy[d]));
     }
     return ret;
   }
-  
-  const std::unordered_set<Vertex> &neighbors(Vertex v) const {
-    return adj.at(v);
-  }
 
-  // Neighbors including v itself
-  std::unordered_set<Vertex> closedNeighbors(Vertex v) const {
-    std::unordered_set<Vertex> ret = neighbors(v);
-    ret.insert(v);
-    return ret;
-  }
-  
-  std::vector<Vertex> bfs(Vertex v, int maxv = 0) const {
-    std::unordered_set<Vertex> visited;
-    std::vector<Vertex> ret;
-    std::queue<Vertex> fifo;
-    
+  std::vector<int> bfs(int v, int maxv = 0) const {
+    std::vector<bool> visited(countVertices(), false);
+    std::vector<int> ret;
+    std::queue<int> fifo;
+
     if(maxv == 0)
       maxv = countVertices();
-    
+
     fifo.push(v);
     while(!fifo.empty() && ret.size() < (size_t) maxv) {
-      Vertex u = fifo.front();
+      int u = fifo.front();
       fifo.pop();
-      if(visited.count(u) != 0)
+      if(visited[u])
         continue;
       ret.push_back(u);
-      visited.insert(u);
-      for(Vertex w : neighbors(u))
+      visited[u] = true;
+      for(int w : neighbors(u))
         fifo.push(w);
     }
-    
+
     return ret;
   }
 };
@@ -0,0 +1,123 @@
+#ifndef KERNEL_HPP
+#define KERNEL_HPP
+
+#include "graph.hpp"
+#include <deque>
+#include <vector>
+
+// Vertices whose fate is known before the search, from the reduction rules
+// for dominating sets, applied until none of them changes anything:
+//  - Dominated neighborhood: v is never needed if a neighbor w dominates
+//    every vertex of N[v] that is left to dominate. Twins (N[v] = N[w]) are
+//    the special case where one of the two is kept.
+//  - Forced vertex: if a vertex left to dominate has a single candidate in
+//    its closed neighborhood, that candidate is fixed in the solution. The
+//    neighbor of a leaf is forced this way once the leaf is excluded.
+// Exclusions chain to a vertex that is never excluded, so some optimal
+// dominating set contains the fixed vertices and no excluded one.
+struct Kernel {
+  std::vector<int> fixed;
+  std::vector<char> is_fixed, excluded;
+  std::vector<char> covered;  // Dominated by the fixed vertices
+  std::vector<int> free;      // Vertices left to dominate
+};
+
+template<class Vertex>
+Kernel reduce(const Graph<Vertex> &g) {
+  int n = g.countVertices();
+  Kernel k{{}, std::vector<char>(n, 0), std::vector<char>(n, 0), std::vector<char>(n, 0), {}};
+  std::vector<char> mark(n, 0);
+
+  // Number of marked vertices in N[w]
+  auto count_marked = [&](int w) {
+    int ret = mark[w];
+    for(int x : g.neighbors(w))
+      ret += mark[x];
+    return ret;
+  };
+
+  // Tests to run again on each vertex, in the order they were queued as
+  // passes over the vertices would. Exclusions only get easier when
+  // vertices get covered: fixing x covers N[x], so it changes them up to
+  // distance 2. Forcings only get easier when vertices get excluded, which
+  // changes them on N[x]. On long chains, passes over every vertex would
+  // settle a few of them at a time
+  enum { exclusion = 1, forcing = 2 };
+  std::deque<int> work;
+  std::vector<char> pending(n, exclusion | forcing);
+  for(int v = 0; v < n; v++)
+    work.push_back(v);
+  auto push = [&](int v, char tests) {
+    if(!pending[v])
+      work.push_back(v);
+    pending[v] |= tests;
+  };
+  auto push_closed = [&](int x, char tests) {
+    push(x, tests);
+    for(int u : g.neighbors(x))
+      push(u, tests);
+  };
+
+  while(!work.empty()) {
+    int v = work.front();
+    work.pop_front();
+    char tests = pending[v];
+    pending[v] = 0;
+
+    if((tests & exclusion) && !k.excluded[v] && !k.is_fixed[v]) {
+      int need = !k.covered[v];
+      mark[v] = !k.covered[v];
+      for(int u : g.neighbors(v)) {
+        mark[u] = !k.covered[u];
+        need += mark[u];
+      }
+
+      bool dominated = need == 0;
+      for(int w : g.neighbors(v)) {
+        if(dominated)
+          break;
+        dominated = !k.excluded[w] && count_marked(w) == need;
+      }
+
+      mark[v] = 0;
+      for(int u : g.neighbors(v))
+        mark[u] = 0;
+
+      if(dominated) {
+        k.excluded[v] = 1;
+        push_closed(v, forcing);
+      }
+    }
+
+    if((tests & forcing) && !k.covered[v]) {
+      int options = 0, last = -1;
+      if(!k.excluded[v]) {
+        options++;
+        last = v;
+      }
+      for(int u : g.neighbors(v)) {
+        if(!k.excluded[u]) {
+          options++;
+          last = u;
+        }
+      }
+      if(options == 1) {
+        k.fixed.push_back(last);
+        k.is_fixed[last] = 1;
+        k.covered[last] = 1;
+        for(int u : g.neighbors(last))
+          k.covered[u] = 1;
+        push_closed(last, exclusion);
+        for(int u : g.neighbors(last))
+          push_closed(u, exclusion);
+      }
+    }
+  }
+
+  for(int v = 0; v < n; v++)
+    if(!k.covered[v])
+      k.free.push_back(v);
+  return k;
+}
+
+#endif
@@ -0,0 +1,268 @@
+#ifndef LOCALSEARCH_HPP
+#define LOCALSEARCH_HPP
+
+#include "graph.hpp"
+#include "tools.hpp"
+#include "kernel.hpp"
+#include "solver.hpp"
+#include <cstdint>
+#include <vector>
+
+// Local search over sets one vertex smaller than the best dominating set
+// found, in the style of CC2FS (Wang, Cai et al., 2017): each move removes a
+// vertex from the set and adds a neighbor of a random non dominated vertex.
+//  - Every vertex has a weight, which grows while it is not dominated, so
+//    that the search turns to the vertices that are hard to dominate.
+//  - Scores are kept up to date on every flip, in O(deg^2): the gain of a
+//    vertex out of the set is the weight of the vertices it would dominate,
+//    the score of a vertex in the set minus the weight of the vertices that
+//    only it dominates.
+//  - The vertex removed is the best of a sample of the set: the one that
+//    leaves the fewest vertices non dominated, then the best score. Counting
+//    before weighing keeps the non dominated vertices few.
+//  - Configuration checking: a vertex that left the set only comes back
+//    once one of its neighbors has changed, which avoids cycling.
+// Same interface as Solver: improve runs a batch of moves, moves counts
+// them, and solution is the best dominating set found.
+template<class Vertex>
+class FastSearch {
+  Generator rng;
+  const Graph<Vertex> &g;
+  const Kernel &kernel;
+  int n;
+  SparseSet dominating;       // Vertices in the set, but the fixed ones
+  SparseSet not_dominated;
+  std::vector<char> in;       // Whether each vertex is in the set, fixed ones included
+  std::vector<int> dominators;
+  std::vector<long> weight, score;
+  // Vertices that only v dominates, for v in the set
+  std::vector<int> sole;
+  std::vector<char> conf;     // Whether each vertex may enter the set
+  std::vector<long> age;      // Move where each vertex last changed
+  long step = 0;             // Moves so far, dates the changes
+  int tabu = -1;              // Just added, not removed by the next move
+  long weights;               // Sum of the weights
+  std::vector<int> best;
+
+  template<class F>
+  void for_closed(int v, F &&f) const {
+    f(v);
+    for(int u : g.neighbors(v))
+      f(u);
+  }
+
+public:
+  // Moves of each improve, vertices sampled to choose the one to remove, and
+  // average weight above which the weights are halved
+  static constexpr long batch = 1024;
+  static constexpr int samples = 64;
+  static constexpr long forgetAbove = 100;
+
+  FastSearch(const Graph<Vertex> &_g, const Kernel &_kernel, unsigned seed) :
+    rng(seed),
+    g(_g),
+    kernel(_kernel),
+    n(g.countVertices()),
+    dominating(n),
+    not_dominated(n),
+    in(n, 0),
+    dominators(n, 0),
+    weight(n, 1),
+    score(n),
+    sole(n, 0),
+    conf(n, 1),
+    age(n, 0),
+    weights(n) {
+    for(int v = 0; v < n; v++) {
+      not_dominated.insert(v);
+      score[v] = g.degree(v) + 1;
+    }
+    for(int v : kernel.fixed)
+      insert(v);
+  }
+
+  // Adds v to the set and updates the scores around it
+  void insert(int v) {
+    in[v] = 1;
+    long loss = 0;
+    sole[v] = 0;
+    for_closed(v, [&](int u) {
+      if(dominators[u]++ == 0) {
+        not_dominated.erase(u);
+        for_closed(u, [&](int x) { score[x] -= weight[u]; });
+        loss += weight[u];
+        sole[v]++;
+      }
+      else if(dominators[u] == 2) {
+        for_closed(u, [&](int x) {
+          if(in[x] && x != v) {
+            score[x] += weight[u];
+            sole[x]--;
+          }
+        });
+      }
+    });
+    score[v] = -loss;
+    if(!kernel.is_fixed[v])
+      dominating.insert(v);
+    touch(v);
+  }
+
+  // Removes v from the set and updates the scores around it
+  void erase(int v) {
+    in[v] = 0;
+    dominating.erase(v);
+    long gain = 0;
+    for_closed(v, [&](int u) {
+      if(--dominators[u] == 0) {
+        not_dominated.insert(u);
+        for_closed(u, [&](int x) { score[x] += weight[u]; });
+        gain += weight[u];
+      }
+      else if(dominators[u] == 1) {
+        for_closed(u, [&](int x) {
+          if(in[x]) {
+            score[x] -= weight[u];
+            sole[x]++;
+          }
+        });
+      }
+    });
+    score[v] = gain;
+    touch(v);
+    conf[v] = 0;
+  }
+
+  // v changed: its neighbors may enter the set
+  void touch(int v) {
+    age[v] = step;
+    for(int u : g.neighbors(v))
+      conf[u] = 1;
+  }
+
+  // Best vertex to remove among a sample of the set, the one that changed
+  // the longest ago on ties. The tabu vertex only if nothing else was drawn.
+  // The sample is a window of consecutive positions from a random one: the
+  // order of the set is already mixed by its erasures, and one draw of the
+  // generator costs more than the rest of the window
+  int choose_removal() {
+    const std::vector<int> &candidates = dominating.elements();
+    size_t k = (uint64_t) rng() * candidates.size() >> 32;
+    int ret = -1;
+    for(int drawn = 0; drawn < samples; drawn++, k = k + 1 < candidates.size() ? k + 1 : 0) {
+      int v = candidates[k];
+      if(v == tabu)
+        continue;
+      if(ret < 0 || sole[v] < sole[ret] ||
+         (sole[v] == sole[ret] && (score[v] > score[ret] || (score[v] == score[ret] && age[v] < age[ret]))))
+        ret = v;
+    }
+    return ret < 0 ? tabu : ret;
+  }
+
+  // Neighbor of a random non dominated vertex with the best gain, among the
+  // ones configuration checking allows if any
+  int choose_insertion() {
+    int u = random_element(not_dominated.elements(), rng);
+    int ret = -1;
+    bool allowed = false;
+    for_closed(u, [&](int x) {
+      if(kernel.excluded[x])
+        return;
+      bool better = ret < 0 || (conf[x] && !allowed) ||
+                    (conf[x] == allowed && (score[x] > score[ret] || (score[x] == score[ret] && age[x] < age[ret])));
+      if(better) {
+        ret = x;
+        allowed = conf[x];
+      }
+    });
+    return ret;
+  }
+
+  // The non dominated vertices get heavier. When the weights get too large
+  // on average they are halved and the scores recomputed, so that old
+  // difficulties are forgotten
+  void raise_weights() {
+    for(int u : not_dominated) {
+      weight[u]++;
+      weights++;
+      for_closed(u, [&](int x) { score[x]++; });
+    }
+    if(weights <= forgetAbove * n)
+      return;
+
+    weights = 0;
+    for(int v = 0; v < n; v++) {
+      weight[v] = (weight[v] + 1) / 2;
+      weights += weight[v];
+      score[v] = 0;
+    }
+    for(int u = 0; u < n; u++) {
+      if(dominators[u] == 0)
+        for_closed(u, [&](int x) { score[x] += weight[u]; });
+      else if(dominators[u] == 1)
+        for_closed(u, [&](int x) {
+          if(in[x])
+            score[x] -= weight[u];
+        });
+    }
+  }
+
+  // The set dominates everything: it is the best one found, and vertices
+  // leave it until it does not
+  void record() {
+    while(not_dominated.empty()) {
+      best = kernel.fixed;
+      best.insert(best.end(), dominating.begin(), dominating.end());
+      if(dominating.empty())
+        return;
+      erase(choose_removal());
+    }
+  }
+
+  void solve_greedy() {
+    load({});
+  }
+
+  // Starts from a known dominating set, completed by greedy if needed
+  void load(const std::vector<int> &dom) {
+    Solver<Vertex> start(g, kernel, rng());
+    start.load(dom);
+    for(int v : start.solution())
+      if(!in[v])
+        insert(v);
+    record();
+  }
+
+  // Runs a batch of moves, returns true when a smaller dominating set was
+  // found
+  bool improve() {
+    // Nothing left to remove: the set is optimal, the batch still counts so
+    // that a budget of moves runs out
+    if(dominating.empty()) {
+      step += batch;
+      return false;
+    }
+    size_t previous = best.size();
+    for(long k = 0; k < batch && !dominating.empty(); k++) {
+      step++;
+      erase(choose_removal());
+      int v = choose_insertion();
+      insert(v);
+      tabu = v;
+      raise_weights();
+      record();
+    }
+    return best.size() < previous;
+  }
+
+  long moves() const {
+    return step;
+  }
+
+  const std::vector<int> &solution() {
+    return best;
+  }
+};
+
+#endif
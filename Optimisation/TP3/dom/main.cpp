@@ -2,7 +2,17 @@
 #include <iostream>
 #include "graph.hpp"
 #include "solver.hpp"
+#include "localsearch.hpp"
 #include "tools.hpp"
+#include "portfolio.hpp"
+#include "kernel.hpp"
+#include "checkpoint.hpp"
+#include "telemetry.hpp"
+#include "verify.hpp"
+#include <cassert>
+#include <algorithm>
+#include <functional>
+#include <mutex>
 
 using namespace std;
 using Vertex = long long int;
@@ -10,8 +20,9 @@ using Vertex = long long int;
 double maxtime = 120;
 
 int main(int argc, char **argv) {
-  if(argc != 2) {
-    cout << "./main inputfile" << endl;
+  Portfolio portfolio;
+  if(argc < 2 || !portfolio.parse(argc - 2, argv + 2)) {
+    cout << "./main inputfile [--threads=N] [--seed=S] [--from-best] [--resume=file.dom] [--engine=repair|fast] [--telemetry=file.csv] [--iterations=MOVES [--restarts=R]]" << endl;
     exit(1);
   }
 
@@ -19,37 +30,114 @@ int main(int argc, char **argv) {
   cout << "Read input graph with " << g.countVertices() << " vertices and "
                                    << g.countEdges() << " edges" << endl;
 
-  std::unordered_set<Vertex> solution;
+  Kernel kernel = reduce(g); // Vertices whose fate is known
+  cout << "Kernel fixes " << kernel.fixed.size() << " vertices, excludes "
+       << std::count(kernel.excluded.begin(), kernel.excluded.end(), 1) << " and leaves "
+       << kernel.free.size() << " to dominate" << endl;
 
-  while(elapsed() < maxtime) {
-    int iterations = 0;
-    Solver<Vertex> solver(g);
-    
-    solver.solve_greedy();
+  string outfn = argv[1]; // Create filename for output
+  outfn.replace(outfn.end()-5, outfn.end(), "dom");
 
-    std::cout << "Dominating set size: "
-              << solver.solution().size()
-              << std::flush;
-    
-    double improved = elapsed();
+  // The best solution is on disk whenever it improves, at most every second
+  BestSolution<std::less<size_t>> best;
+  Checkpoint<Vertex> checkpoint(g, outfn);
+  auto publish = [&](const std::vector<int> &solution) {
+    if(best.offer(solution))
+      checkpoint.offer(*best.get());
+  };
+  Telemetry<std::less<size_t>> telemetry(portfolio.telemetry, "moves");
+  stop_on_signals();
 
-    while(elapsed() < maxtime && elapsed() - improved < maxtime / 8) {
-      if(solver.improve()) {
-        std::cout << " -> " << solver.solution().size() << std::flush;
-        improved = elapsed();
-      }
-      iterations++;
+  if(!portfolio.resume.empty()) {
+    Solver<Vertex> solver(g, kernel, portfolio.seed);
+    auto resumed = read_solution(portfolio.resume, g);
+    if(!resumed) {
+      cout << "Cannot resume from " << portfolio.resume << ": no vertex of the graph read" << endl;
+      exit(1);
     }
-
-    if(solution.empty() || solver.solution().size() < solution.size())
-      solution = solver.solution();
-    
-    std::cout << std::endl << "After " << iterations << " iterations, we found a dominating set of size " << solver.solution().size() << " and the best size found is " << solution.size() << std::endl;
+    solver.load(*resumed);
+    publish(solver.solution());
+    cout << "Resumed from a dominating set of size " << solver.solution().size() << endl;
   }
 
-  string outfn = argv[1]; // Create filename for output
-  outfn.replace(outfn.end()-5, outfn.end(), "dom");
-  save(outfn, solution);
+  std::mutex output;
+  bool verbose = portfolio.threads == 1; // Progress of each improvement
+
+  portfolio.run([&](int worker) {
+    Generator rng(portfolio.worker_seed(worker));
+    bool resume = !portfolio.resume.empty();
+    auto trace = telemetry.trace(worker);
+
+    // One restart, from greedy or from a known solution
+    // Progress is counted in moves, which both engines share: a Solver
+    // improve is one move, a FastSearch one a batch of them
+    auto restart = [&](auto &&solver) {
+      long moves = 0, calls = 0;
+      auto start = portfolio.from_best || resume ? best.get() : nullptr;
+      resume = false;
+      if(start)
+        solver.load(*start);
+      else
+        solver.solve_greedy();
+
+      if(verbose)
+        std::cout << "Dominating set size: "
+                  << solver.solution().size()
+                  << std::flush;
+
+      double improved = elapsed();
+      trace.start(improved, solver.solution().size());
+      LazyClock clock; // About one clock read per millisecond, not two per iteration
+
+      // A counted budget never reads the clock, so that the run only depends
+      // on the seed. Its iterations are moves
+      auto going = [&] {
+        if(interrupted)
+          return false;
+        if(portfolio.counted())
+          return moves < portfolio.iterations;
+        double now = clock.now();
+        return now < maxtime && now - improved < maxtime / 8;
+      };
+
+      while(going()) {
+        bool success = solver.improve();
+        moves = solver.moves();
+        calls++;
+        if(success) {
+          if(verbose)
+            std::cout << " -> " << solver.solution().size() << std::flush;
+          improved = elapsed();
+          trace.improved(improved, solver.solution().size(), moves);
+          if(checkpoint.due())
+            publish(solver.solution());
+        }
+      }
+
+      trace.end(elapsed(), solver.solution().size(), moves, calls);
+      publish(solver.solution());
+
+      std::lock_guard lock(output);
+      if(verbose)
+        std::cout << std::endl;
+      else
+        std::cout << "Worker " << worker << ": ";
+      std::cout << "After " << moves << " moves, we found a dominating set of size " << solver.solution().size() << " and the best size found is " << best.get()->size() << std::endl;
+    };
+
+    for(long restarts = 0; !interrupted && (portfolio.counted() ? restarts < portfolio.restarts : elapsed() < maxtime); restarts++) {
+      if(portfolio.engine == "fast")
+        restart(FastSearch<Vertex>(g, kernel, rng()));
+      else
+        restart(Solver<Vertex>(g, kernel, rng()));
+    }
+    telemetry.add(std::move(trace));
+  });
+  telemetry.write();
+
+  auto solution = best.get();
+  assert(!solution || undominated(g, *solution).empty());
+  save(outfn, solution ? *solution : std::vector<int>(), g);
   
   return 0;
 }
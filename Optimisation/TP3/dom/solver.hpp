@@ -3,197 +3,360 @@
 
 #include "graph.hpp"
 #include "tools.hpp"
+#include "kernel.hpp"
+#include "checkpoint.hpp"
 #include <iostream>
-#include <unordered_set>
-#include <queue>
+#include <vector>
 #include <cassert>
 
 
+// Vertices are the dense ids 0..n-1 of the graph, translated back to the
+// ids of the file only by save
+// The fixed vertices of the kernel are in the dominating set from the
+// start and never leave it, its excluded vertices never enter it
 template<class Vertex>
 class Solver {
+  Generator rng;
   const Graph<Vertex> &g;
-  std::unordered_set<Vertex> dominating, not_dominating, dominated, not_dominated;
-  std::vector<Vertex> vertices;
-  std::priority_queue<std::pair<int,Vertex>> heap;
+  const Kernel &kernel;
+  int n;
+  SparseSet dominating, not_dominated;
+  // Number of dominating vertices in the closed neighborhood of each vertex
+  std::vector<int> dominators;
+  // Number of non dominated vertices in the closed neighborhood of each vertex
+  std::vector<int> gain;
+  // Vertices out of the dominating set, by gain
+  BucketQueue candidates;
+  // Scratch marks, always cleared after use
+  mutable std::vector<char> mark;
+  // Scratch indices of the vertices in the repair, -1 outside of it
+  std::vector<int> slot;
+  // Calls to improve, one move each
+  long step = 0;
+
+  // Calls f on v and its neighbors, without copying the neighborhood
+  template<class F>
+  void for_closed(int v, F &&f) const {
+    f(v);
+    for(int u : g.neighbors(v))
+      f(u);
+  }
 
 public:
-  Solver(const Graph<Vertex> &_g) :
+  // Dominating vertices erased by improve, and nodes the repair may explore
+  static constexpr size_t destroyed = 8;
+  static constexpr long maxRepairNodes = 2000;
+
+  Solver(const Graph<Vertex> &_g, const Kernel &_kernel, unsigned seed) :
+    rng(seed),
     g(_g),
-    not_dominating(g.vertices()),
-    not_dominated(not_dominating),
-    vertices(not_dominating.begin(), not_dominating.end()) {
+    kernel(_kernel),
+    n(g.countVertices()),
+    dominating(n),
+    not_dominated(n),
+    dominators(n, 0),
+    gain(n),
+    candidates(n, g.maxDegree() + 1),
+    mark(n, 0),
+    slot(n, -1) {
+    for(int v = 0; v < n; v++) {
+      not_dominated.insert(v);
+      gain[v] = g.degree(v) + 1;
+      if(!kernel.excluded[v])
+        candidates.insert(v, gain[v]);
+    }
+    for(int v : kernel.fixed)
+      insert_dominating(v);
+  }
+
+  // Adds delta to the gain of the closed neighbors of v
+  void shift_gains(int v, int delta) {
+    for_closed(v, [&](int u) {
+      gain[u] += delta;
+      if(candidates.contains(u))
+        candidates.update(u, gain[u]);
+    });
   }
 
   // Insert a vertex v in the dominating set, updating all sets accordingly
-  void insert_dominating(Vertex v) {
-    dominating.insert(v);
-    not_dominating.erase(v);
+  void insert_dominating(int v) {
+    if(!dominating.insert(v))
+      return;
+    candidates.erase(v);
     // Neighbors of v are now dominated
-    for(Vertex u : g.closedNeighbors(v)) {
-      dominated.insert(u);
-      not_dominated.erase(u);
-    }
+    for_closed(v, [&](int u) {
+      if(dominators[u]++ == 0) {
+        not_dominated.erase(u);
+        shift_gains(u, -1);
+      }
+    });
   }
 
-  // Tests if a vertex v is dominated using only dominating
-  // Needed to update dominated on erase_dominating
-  bool test_dominated(Vertex v) const {
-    for(Vertex u : g.closedNeighbors(v)) {
-      if(dominating.contains(u))
-        return true;
-    }
-    return false;
+  // A vertex is dominated when one of its closed neighbors is dominating
+  bool test_dominated(int v) const {
+    return dominators[v] > 0;
   }
 
-  // Insert a vertex v in the dominating set, updating all sets accordingly
+  // Erase a vertex v from the dominating set, updating all sets accordingly
   // Returns false if the vertex was not in the dominating set
-  bool erase_dominating(Vertex v) {
-    if(!dominating.contains(v))
+  bool erase_dominating(int v) {
+    if(kernel.is_fixed[v] || !dominating.erase(v))
       return false;
-    dominating.erase(v);
-    not_dominating.insert(v);
-    for(Vertex u : g.closedNeighbors(v)) {
-      if(!test_dominated(u)) {
-        dominated.erase(u);
+    for_closed(v, [&](int u) {
+      if(--dominators[u] == 0) {
         not_dominated.insert(u);
+        shift_gains(u, +1);
       }
-    }
+    });
+    candidates.insert(v, gain[v]);
     return true;
   }
 
   // Counts the number of vertices that would change into dominated if v is inserted into dominating
-  int count_domination(Vertex v) const {
-    int ret = 0;
-    for(Vertex u : g.closedNeighbors(v)) {
-      if(!dominated.contains(u))
-        ret++;
-    }
+  int count_domination(int v) const {
+    return gain[v];
+  }
 
-    return ret;
+  // One of the vertices of largest gain, at random
+  int choose_vertex() {
+    assert(!candidates.empty());
+    return random_element(candidates.maxBucket(), rng);
   }
 
-  Vertex choose_vertex() {
-    std::vector<Vertex> best_vertices;
-    int best_value = 0;
 
-    while(!heap.empty() &&
-        (best_vertices.empty() || heap.top().first == best_value)) {
-      auto [old_val,v] = heap.top();
-      heap.pop();
-      if (!dominating.contains(v)) {
-        int cur_val = count_domination(v);
-        if(old_val == cur_val) {
-          best_vertices.push_back(v);
-          best_value = cur_val;
-        }
-        else {
-          auto p = std::make_pair(cur_val,v);
-          heap.push(p);
-        }
-      }
+  void solve_greedy() {
+    while(not_dominated.size()) {
+      int v = choose_vertex();
+      insert_dominating(v);
     }
+  }
 
-    assert(!best_vertices.empty());
-
-    Vertex ret = random_element(best_vertices);
-    for(Vertex v : best_vertices) {
-      if(v != ret) {
-        auto p = std::make_pair(best_value,v);
-        heap.push(p);
-      }
-    }
+  // Starts from a known dominating set instead of the greedy one. Excluded
+  // vertices are skipped and greedy completes the set if needed
+  void load(const std::vector<int> &dom) {
+    for(int v : dom)
+      if(!kernel.excluded[v])
+        insert_dominating(v);
+    solve_greedy();
+  }
 
+  bool would_dominate_all(const std::vector<int> &dom) const {
+    for(int v : dom)
+      for_closed(v, [&](int u) { mark[u] = 1; });
+    bool ret = std::all_of(not_dominated.begin(), not_dominated.end(),
+                           [&](int v) { return mark[v]; });
+    for(int v : dom)
+      for_closed(v, [&](int u) { mark[u] = 0; });
     return ret;
   }
 
+  // Very slow function to find the smallest set of vertices to insert to get a dominating set
+  // Only efficient if very few vertices need to be inserted
+  // A known solution is given as a parameter
+  void solve_exact(int removed) {
+    std::vector<int> candidates;
 
-  void solve_greedy() {
-    for(Vertex v : not_dominating) {
-      auto p = std::make_pair(count_domination(v),v);
-      heap.push(p);
+    for(int v : not_dominated) {
+      for_closed(v, [&](int u) {
+        if(!mark[u] && !kernel.excluded[u]) {
+          mark[u] = 1;
+          candidates.push_back(u);
+        }
+      });
     }
+    for(int u : candidates)
+      mark[u] = 0;
 
-    while(not_dominated.size()) {
-      Vertex v = choose_vertex();
-      insert_dominating(v);
+    std::shuffle(candidates.begin(), candidates.end(), rng);
+    for(int sz = 0; sz <= removed; sz++) {
+      bool found = any_combination(candidates, sz, rng, [&](const std::vector<int> &dom) {
+        if(!would_dominate_all(dom))
+          return false;
+        for(int v : dom)
+          insert_dominating(v);
+        return true;
+      });
+      if(found)
+        return;
     }
+
+    assert(false);
   }
 
-  bool would_dominate_all(const std::vector<Vertex> &dom) const {
-    std::unordered_set<Vertex> neighbors;
-    for(Vertex v : dom) {
-      auto nv = g.closedNeighbors(v);
-      neighbors.insert(nv.begin(),nv.end());
-    }
-    for(Vertex v : not_dominated) {
-      if(!neighbors.contains(v))
-        return false;
-    }
-    return true;
+  // Number of vertices that would stop being dominated if v is erased
+  int count_undomination(int v) const {
+    int ret = 0;
+    for_closed(v, [&](int u) {
+      if(dominators[u] == 1)
+        ret++;
+    });
+    return ret;
   }
 
-  // Very slow function to find the smallest set of vertices to insert to get a dominating set
-  // Only efficient if very few vertices need to be inserted
-  // A known solution is given as a parameter
-  void solve_exact(const std::unordered_set<long long int> &removed) {
-    std::unordered_set<Vertex> candidates;
+  // Exact set cover of the non dominated vertices, which must fit in a Mask,
+  // by branch and bound. Inserts the smallest set of vertices dominating them
+  // found within maxRepairNodes nodes, branching on the vertex that has the
+  // fewest candidates.
+  // The removed vertices are a known solution: they are reinserted if the
+  // search runs out of nodes before finding anything.
+  void repair(const std::vector<int> &removed) {
+    const std::vector<int> &targets = not_dominated.elements();
+    int t = targets.size();
+    for(int k = 0; k < t; k++)
+      slot[targets[k]] = k;
 
-    for(Vertex v :not_dominated) {
-      auto nv = g.closedNeighbors(v);
-      candidates.insert(nv.begin(), nv.end());
+    // Candidates in random order, with the targets they dominate
+    std::vector<int> cand;
+    for(int u : targets) {
+      for_closed(u, [&](int c) {
+        if(!mark[c] && !kernel.excluded[c]) {
+          mark[c] = 1;
+          cand.push_back(c);
+        }
+      });
     }
-
-    for(size_t sz = 0; sz <= removed.size(); sz++) {
-      std::vector<std::vector<Vertex>> comb = combinations(candidates, sz);
-      std::shuffle(comb.begin(), comb.end(), rgen);
-      for(std::vector<Vertex> dom : comb) {
-        if(would_dominate_all(dom)) {
-          for(Vertex v : dom)
-            insert_dominating(v);
-          return;
+    std::shuffle(cand.begin(), cand.end(), rng);
+    std::vector<Mask> cover(cand.size(), 0);
+    std::vector<std::vector<int>> coverers(t);
+    int widest = 1;
+    for(size_t i = 0; i < cand.size(); i++) {
+      mark[cand[i]] = 0;
+      for_closed(cand[i], [&](int u) {
+        if(slot[u] >= 0) {
+          cover[i] |= bit(slot[u]);
+          coverers[slot[u]].push_back(i);
         }
-      }
+      });
+      widest = std::max(widest, popcount(cover[i]));
     }
+    for(int u : targets)
+      slot[u] = -1;
 
-    assert(false);
+    // Targets sharing a candidate with each target. Targets that share none
+    // pairwise need one vertex each, which bounds the size of any cover
+    std::vector<Mask> conflict(t, 0);
+    for(int u = 0; u < t; u++)
+      for(int i : coverers[u])
+        conflict[u] |= cover[i];
+    auto lower_bound = [&](Mask uncovered) {
+      int packed = 0;
+      for(Mask m = uncovered; m; m &= ~conflict[lowest(m)])
+        packed++;
+      return std::max(packed, (popcount(uncovered) + widest - 1) / widest);
+    };
+
+    std::vector<int> chosen, best;
+    size_t bound = removed.size() + 1;
+    long nodes = maxRepairNodes;
+
+    auto search = [&](auto &&self, Mask uncovered) -> void {
+      if(uncovered == 0) {
+        best = chosen;
+        bound = chosen.size();
+        return;
+      }
+      if(--nodes < 0 || chosen.size() + lower_bound(uncovered) >= bound)
+        return;
+
+      // The hardest target is the one with the fewest candidates
+      int hardest = -1;
+      for(Mask m = uncovered; m; m &= m - 1) {
+        int u = lowest(m);
+        if(hardest < 0 || coverers[u].size() < coverers[hardest].size())
+          hardest = u;
+      }
+
+      // Candidates dominating the most uncovered targets first
+      std::vector<int> order = coverers[hardest];
+      std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return popcount(cover[a] & uncovered) > popcount(cover[b] & uncovered);
+      });
+      for(int i : order) {
+        chosen.push_back(cand[i]);
+        self(self, uncovered & ~cover[i]);
+        chosen.pop_back();
+      }
+    };
+    search(search, t == maskBits ? ~(Mask) 0 : bit(t) - 1);
+
+    for(int v : best.empty() && t > 0 ? removed : best)
+      insert_dominating(v);
   }
 
 
   // Tries to decrease the size of the dominating set
+  // Erases up to destroyed dominating vertices around a random vertex, in
+  // breadth first order, and inserts back a smallest set dominating the
+  // same vertices
   // Returns true when succesful
   // It will never increase the size
   bool improve() {
+    step++;
+    if(kernel.free.empty())
+      return false;
     size_t previous = dominating.size();
-    Vertex v = random_element(vertices);
-    int count = 0;
-    std::unordered_set<Vertex> removed;
-    for(Vertex u : g.closedNeighbors(v)) {
-      if(erase_dominating(u)) {
-        count++;
-        removed.insert(u);
+    int v = random_element(kernel.free, rng);
+    std::vector<int> removed, ball{v};
+    mark[v] = 1;
+    for(size_t k = 0; k < ball.size() && removed.size() < destroyed; k++) {
+      int u = ball[k];
+      if(dominating.contains(u) && !kernel.is_fixed[u]) {
+        if(not_dominated.size() + count_undomination(u) > maskBits)
+          break;
+        erase_dominating(u);
+        removed.push_back(u);
       }
-      if(count > 3) { // The exact solver is too slow to handle more than 4
-        break;
+      for(int w : g.neighbors(u)) {
+        if(!mark[w]) {
+          mark[w] = 1;
+          ball.push_back(w);
+        }
       }
     }
+    for(int u : ball)
+      mark[u] = 0;
+
+    if(!removed.empty()) {
+      repair(removed);
+      return dominating.size() < previous;
+    }
 
-    solve_exact(removed);
+    // The vertices one erase leaves non dominated do not fit in a Mask:
+    // enumerate combinations, which are too slow to handle more than 4
+    int count = 0;
+    auto remove = [&](int u) {
+      if(erase_dominating(u))
+        count++;
+      return count > 3;
+    };
+    if(!remove(v)) {
+      for(int u : g.neighbors(v))
+        if(remove(u))
+          break;
+    }
+
+    solve_exact(count);
     return dominating.size() < previous;
   }
 
 
+  // Moves run so far, the same unit as FastSearch
+  long moves() const {
+    return step;
+  }
+
   // Getter for the solution
-  const std::unordered_set<Vertex> &solution() {
-    return dominating;
+  const std::vector<int> &solution() {
+    return dominating.elements();
   }
 };
 
-// Save the solution to a file
+// Save the solution to a file, with the vertex ids of the input
 template<class Vertex>
-void save(const std::string &outfn, std::unordered_set<Vertex> solution) {
-  std::ofstream outfile(outfn);
-  for(Vertex v : solution) {
-    outfile << v << std::endl;
+void save(const std::string &outfn, const std::vector<int> &solution, const Graph<Vertex> &g) {
+  if(!write_solution(outfn, solution, g)) {
+    std::cout << "Could not write " << outfn << std::endl;
+    return;
   }
   std::cout << "Saved a dominating set of size " << solution.size() << std::endl;
 }
@@ -0,0 +1,130 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Anytime behaviour of the search, written as CSV with one row per event:
+//   start    a restart has its initial solution
+//   improve  improve() succeeded, seconds is the time since the previous
+//            success of the restart (or its start)
+//   end      the restart is over, seconds is its duration
+// best is the best size of any worker so far, iterations and successes are
+// counted from the start of the restart. The iterations column is named
+// after their unit, which depends on the main, successes are the calls to
+// improve() that succeeded. Better compares two sizes.
+template<class Better>
+class Telemetry {
+public:
+  struct Event {
+    const char *kind;
+    double time;
+    int worker, restart;
+    std::size_t size;
+    long iterations, successes;
+    double seconds;
+    long calls; // Calls to improve(), end events only
+  };
+
+  // Events of one worker, recorded without locking
+  class Trace {
+    friend class Telemetry;
+    bool on;
+    int worker, restart = -1;
+    double begin = 0, last = 0;
+    long successes = 0;
+    std::vector<Event> events;
+
+  public:
+    Trace(bool _on, int _worker) : on(_on), worker(_worker) {
+    }
+
+    void start(double t, std::size_t size) {
+      restart++;
+      begin = last = t;
+      successes = 0;
+      if(on)
+        events.push_back({"start", t, worker, restart, size, 0, 0, 0, 0});
+    }
+
+    void improved(double t, std::size_t size, long iterations) {
+      successes++;
+      if(on)
+        events.push_back({"improve", t, worker, restart, size, iterations, successes, t - last, 0});
+      last = t;
+    }
+
+    // calls is the number of calls to improve(), when an iteration is not
+    // one call
+    void end(double t, std::size_t size, long iterations, long calls) {
+      if(on)
+        events.push_back({"end", t, worker, restart, size, iterations, successes, t - begin, calls});
+    }
+
+    void end(double t, std::size_t size, long iterations) {
+      end(t, size, iterations, iterations);
+    }
+  };
+
+private:
+  std::string outfn;
+  std::string unit;
+  std::mutex adding;
+  std::vector<Event> events;
+  Better better;
+
+public:
+  // Nothing is recorded when outfn is empty
+  Telemetry(const std::string &_outfn, const std::string &_unit = "iterations") :
+    outfn(_outfn), unit(_unit) {
+  }
+
+  Trace trace(int worker) const {
+    return Trace(!outfn.empty(), worker);
+  }
+
+  void add(Trace &&trace) {
+    std::lock_guard lock(adding);
+    events.insert(events.end(), trace.events.begin(), trace.events.end());
+  }
+
+  // Writes the events in time order and prints the rates
+  void write() {
+    if(outfn.empty())
+      return;
+    std::stable_sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+      return a.time < b.time;
+    });
+
+    std::ofstream out(outfn);
+    out << "event,time,worker,restart,size,best," << unit << ",successes,seconds\n";
+    std::size_t best = 0;
+    bool any = false;
+    long iterations = 0, successes = 0, calls = 0;
+    double seconds = 0;
+    for(const Event &e : events) {
+      if(!any || better(e.size, best))
+        best = e.size;
+      any = true;
+      out << e.kind << ',' << e.time << ',' << e.worker << ',' << e.restart << ','
+          << e.size << ',' << best << ',' << e.iterations << ',' << e.successes << ','
+          << e.seconds << '\n';
+      if(e.kind[0] == 'e') {
+        iterations += e.iterations;
+        successes += e.successes;
+        calls += e.calls;
+        seconds += e.seconds;
+      }
+    }
+
+    std::cout << "Telemetry in " << outfn << ": "
+              << (seconds > 0 ? iterations / seconds : 0) << ' ' << unit << " per second per worker, "
+              << (calls > 0 ? 100.0 * successes / calls : 0) << "% of the calls to improve() succeed" << std::endl;
+  }
+};
+
+#endif
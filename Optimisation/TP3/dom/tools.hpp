@@ -2,7 +2,9 @@
 #define TOOLS_HPP
 
 #include <algorithm>
-#include <unordered_set>
+#include <bit>
+#include <cstdint>
+#include <vector>
 #include <random>
 #include <chrono>
 
@@ -15,39 +17,247 @@ inline double elapsed() {
   return dur.count() / 1000.0;
 }
 
-static std::mt19937 rgen(1);
+// elapsed() for hot loops: the clock is only read once every stride calls.
+// The stride doubles while reads come less than a millisecond apart and
+// halves when they come more than 4 apart
+class LazyClock {
+  double last = elapsed();
+  long stride = 1, left = 1;
+
+public:
+  double now() {
+    if(--left > 0)
+      return last;
+    double t = elapsed();
+    if(t - last < 0.001)
+      stride = std::min(stride * 2, 1l << 20);
+    else if(t - last > 0.004)
+      stride = std::max(stride / 2, 1l);
+    last = t;
+    left = stride;
+    return last;
+  }
+};
+
+// Each solver has its own generator, so that runs are reproducible from
+// their seeds whatever the other threads do
+using Generator = std::mt19937;
 
 // Returns a random element from a vector
 template<class T>
-T random_element(const std::vector<T> &v) {
+T random_element(const std::vector<T> &v, Generator &rng) {
   std::uniform_int_distribution<> distrib2(0,v.size()-1);
-  return v[distrib2(rgen)];
+  return v[distrib2(rng)];
 }
 
 
-// Returns a vectors with all the subsets of s that have size k
-template<class T>
-std::vector<std::vector<T>> combinations(const std::unordered_set<T> &s, int k) {
-  std::vector<std::vector<T>> previous, ret;
-  ret.push_back(std::vector<T>());
-
-  std::vector<T> sv(s.begin(), s.end());
-  std::shuffle(sv.begin(), sv.end(), rgen);
-
-  for(int i = 0; i < k; i++) {
-    previous = ret;
-    ret.clear();
-    for(T k : sv) {
-      for(auto ps : previous) {
-        if(ps.empty() || ps.back() < k) {
-          ps.push_back(k);
-          ret.push_back(ps);
-        }
+// Lazy enumeration of the k-subsets of 0..n-1 in revolving door order:
+// each subset differs from the previous one by one element in and one out.
+// Positions are shifted by offset modulo n, to start anywhere in the order.
+// Knuth, TAOCP 7.2.1.3, Algorithm R. O(k) memory.
+class Combinations {
+  int n, k, offset;
+  std::vector<int> c; // c[1..k] decreasing, c[k+1] = n
+  bool over;
+
+public:
+  Combinations(int _n, int _k, int _offset = 0) :
+    n(_n), k(_k), offset(_offset), c(k + 2), over(k > n) {
+    for(int j = 1; j <= k; j++)
+      c[j] = j - 1;
+    c[k + 1] = n;
+  }
+
+  bool done() const {
+    return over;
+  }
+
+  // The element at position j < k of the current subset
+  int operator[](int j) const {
+    return (c[j + 1] + offset) % n;
+  }
+
+  void next() {
+    if(k == 1 && c[1] + 1 < n) {
+      c[1]++;
+      return;
+    }
+    if(k <= 1 || k == n) {
+      over = true;
+      return;
+    }
+
+    int j;
+    if(k % 2 == 1) {
+      if(c[1] + 1 < c[2]) {
+        c[1]++;
+        return;
       }
+      j = 2;
     }
+    else {
+      if(c[1] > 0) {
+        c[1]--;
+        return;
+      }
+      j = 2;
+      goto increase;
+    }
+
+    while(true) {
+      // Try to decrease c[j], c[j] = c[j-1] + 1
+      if(c[j] >= j) {
+        c[j] = c[j - 1];
+        c[j - 1] = j - 2;
+        return;
+      }
+      j++;
+    increase:
+      // Try to increase c[j], c[j-1] = j - 2
+      if(c[j] + 1 < c[j + 1]) {
+        c[j - 1] = c[j];
+        c[j]++;
+        return;
+      }
+      j++;
+      if(j > k) {
+        over = true;
+        return;
+      }
+    }
+  }
+};
+
+// Calls f on the subsets of s that have size k, in revolving door order from
+// a random starting point, until it returns true. Returns whether it did
+template<class T, class F>
+bool any_combination(const std::vector<T> &s, int k, Generator &rng, F &&f) {
+  int n = s.size();
+  int offset = n > 0 ? std::uniform_int_distribution<>(0, n - 1)(rng) : 0;
+  std::vector<T> subset(k);
+  for(Combinations comb(n, k, offset); !comb.done(); comb.next()) {
+    for(int j = 0; j < k; j++)
+      subset[j] = s[comb[j]];
+    if(f(subset))
+      return true;
+  }
+  return false;
+}
+
+// Set of integers in 0..n-1 with O(1) insert, erase and access by
+// position: the elements are packed in a vector and each one knows its
+// position (-1 when absent), erase moves the last element into the hole
+class SparseSet {
+  std::vector<int> items;
+  std::vector<int> position;
+
+public:
+  SparseSet(int n = 0) : position(n, -1) {
+  }
+
+  bool contains(int v) const {
+    return position[v] >= 0;
+  }
+
+  bool insert(int v) {
+    if(contains(v))
+      return false;
+    position[v] = items.size();
+    items.push_back(v);
+    return true;
+  }
+
+  bool erase(int v) {
+    if(!contains(v))
+      return false;
+    int k = position[v];
+    items[k] = items.back();
+    position[items[k]] = k;
+    items.pop_back();
+    position[v] = -1;
+    return true;
+  }
+
+  std::size_t size() const { return items.size(); }
+  bool empty() const { return items.empty(); }
+  int operator[](std::size_t k) const { return items[k]; }
+  const std::vector<int> &elements() const { return items; }
+  auto begin() const { return items.begin(); }
+  auto end() const { return items.end(); }
+};
+
+// Integers in 0..n-1 bucketed by an integer key in 0..maxKey, with O(1)
+// insert, erase and key change. The largest key is found by walking down
+// from the last one, which is amortized O(1) when keys mostly decrease
+class BucketQueue {
+  std::vector<std::vector<int>> buckets;
+  std::vector<int> key, position; // position is -1 when absent
+  int top = -1;
+
+public:
+  BucketQueue(int n, int maxKey) : buckets(maxKey + 1), key(n, 0), position(n, -1) {
+  }
+
+  bool contains(int v) const {
+    return position[v] >= 0;
+  }
+
+  void insert(int v, int k) {
+    key[v] = k;
+    position[v] = buckets[k].size();
+    buckets[k].push_back(v);
+    top = std::max(top, k);
+  }
+
+  bool erase(int v) {
+    if(!contains(v))
+      return false;
+    std::vector<int> &b = buckets[key[v]];
+    int k = position[v];
+    b[k] = b.back();
+    position[b[k]] = k;
+    b.pop_back();
+    position[v] = -1;
+    return true;
+  }
+
+  void update(int v, int k) {
+    erase(v);
+    insert(v, k);
+  }
+
+  bool empty() {
+    while(top >= 0 && buckets[top].empty())
+      top--;
+    return top < 0;
+  }
+
+  // Largest key and the elements that have it, the queue must not be empty
+  int maxKey() {
+    empty();
+    return top;
   }
 
-  return ret;
+  const std::vector<int> &maxBucket() {
+    return buckets[maxKey()];
+  }
+};
+
+// Set of at most 128 small integers, one bit each
+using Mask = unsigned __int128;
+constexpr int maskBits = 128;
+
+inline Mask bit(int k) {
+  return (Mask) 1 << k;
+}
+
+inline int popcount(Mask m) {
+  return std::popcount((uint64_t) m) + std::popcount((uint64_t) (m >> 64));
+}
+
+// Position of the lowest set bit, m must not be 0
+inline int lowest(Mask m) {
+  return (uint64_t) m ? std::countr_zero((uint64_t) m) : 64 + std::countr_zero((uint64_t) (m >> 64));
 }
 
 #endif
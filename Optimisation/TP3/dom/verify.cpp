@@ -0,0 +1,49 @@
+// Checks a dominating set, like testdom.py without the picture
+#include <iostream>
+#include <fstream>
+#include <unordered_set>
+#include "graph.hpp"
+#include "verify.hpp"
+
+using namespace std;
+using Vertex = long long int;
+
+int main(int argc, char **argv) {
+  if(argc != 3) {
+    cout << "./verify input.edges output.dom" << endl;
+    exit(1);
+  }
+
+  Graph<Vertex> g(argv[1]);
+
+  std::unordered_set<Vertex> labels;
+  std::ifstream infile(argv[2]);
+  Vertex v;
+  while(infile >> v)
+    labels.insert(v);
+  cout << "Size: " << labels.size() << endl;
+
+  int errors = 0;
+  std::vector<int> dom;
+  for(Vertex label : labels) {
+    int id = g.id(label);
+    if(id < 0) {
+      cout << "Vertex does not exist: " << label << endl;
+      errors++;
+    }
+    else
+      dom.push_back(id);
+  }
+
+  for(int u : undominated(g, dom)) {
+    cout << "Undominated vertex: " << g.label(u) << endl;
+    errors++;
+  }
+
+  if(errors)
+    cout << "There are " << errors << " errors" << endl;
+  else
+    cout << "Solution is correct" << endl;
+
+  return std::min(errors, 255);
+}
@@ -0,0 +1,41 @@
+#ifndef VERIFY_HPP
+#define VERIFY_HPP
+
+#include "graph.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Vertices of g not dominated by dom, in increasing order. Membership is a
+// bitset, the vertices are checked in parallel slices
+template<class Vertex>
+std::vector<int> undominated(const Graph<Vertex> &g, const std::vector<int> &dom) {
+  int n = g.countVertices();
+  std::vector<uint64_t> in(n / 64 + 1, 0);
+  for(int v : dom)
+    in[v >> 6] |= uint64_t(1) << (v & 63);
+  auto contains = [&](int v) { return in[v >> 6] >> (v & 63) & 1; };
+
+  unsigned threads = std::clamp(n >> 16, 1, (int) std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::vector<int>> found(threads);
+  parallel(threads, [&](unsigned t, unsigned count) {
+    for(int v = (long long) n * t / count; v < (long long) n * (t + 1) / count; v++) {
+      bool dominated = contains(v);
+      for(int u : g.neighbors(v)) {
+        if(dominated)
+          break;
+        dominated = contains(u);
+      }
+      if(!dominated)
+        found[t].push_back(v);
+    }
+  });
+
+  std::vector<int> ret;
+  for(auto &f : found)
+    ret.insert(ret.end(), f.begin(), f.end());
+  return ret;
+}
+
+#endif
@@ -1,10 +1,11 @@
 #!/bin/bash
 
-g++ -Wfatal-errors -std=c++20 -Ofast -o main main.cpp
+g++ -Wfatal-errors -std=c++20 -Ofast -pthread -o main main.cpp
+g++ -Wfatal-errors -std=c++20 -Ofast -pthread -o verify verify.cpp
 
 for a in ../instances/*.edges
 do
  time ./main $a
- python testind.py $a ${a%.edges}.ind
+ ./verify $a ${a%.edges}.ind
 done
 
@@ -3,6 +3,13 @@
 #include "graph.hpp"
 #include "solver.hpp"
 #include "tools.hpp"
+#include "portfolio.hpp"
+#include "checkpoint.hpp"
+#include "telemetry.hpp"
+#include "verify.hpp"
+#include <cassert>
+#include <functional>
+#include <mutex>
 
 using namespace std;
 using Vertex = long long int;
@@ -10,8 +17,9 @@ using Vertex = long long int;
 double maxtime = 120;
 
 int main(int argc, char **argv) {
-  if(argc != 2) {
-    cout << "./main <inputfile>" << endl;
+  Portfolio portfolio;
+  if(argc < 2 || !portfolio.parse(argc - 2, argv + 2)) {
+    cout << "./main <inputfile> [--threads=N] [--seed=S] [--from-best] [--resume=file.ind] [--telemetry=file.csv] [--iterations=N [--restarts=R]]" << endl;
     exit(1);
   }
 
@@ -19,43 +27,102 @@ int main(int argc, char **argv) {
   cout << "Read input graph with " << g.countVertices() << " vertices and "
                                    << g.countEdges() << " edges" << endl;
 
-  std::unordered_set<Vertex> solution;
+  string outfn = argv[1]; // Create filename for output
+  outfn.replace(outfn.end()-5, outfn.end(), "ind");
+
+  // Larger independant sets are better, the best one is on disk whenever it
+  // improves, at most every second
+  BestSolution<std::greater<size_t>> best;
+  Checkpoint<Vertex> checkpoint(g, outfn);
+  auto publish = [&](const std::vector<int> &solution) {
+    if(best.offer(solution))
+      checkpoint.offer(*best.get());
+  };
+  Telemetry<std::greater<size_t>> telemetry(portfolio.telemetry);
+  stop_on_signals();
 
-  while(elapsed() < maxtime) {
-    int iterations = 0;
-    Solver<Vertex> solver(g);
-    
-    solver.solve_greedy();
+  if(!portfolio.resume.empty()) {
+    Solver<Vertex> solver(g, portfolio.seed);
+    auto resumed = read_solution(portfolio.resume, g);
+    if(!resumed) {
+      cout << "Cannot resume from " << portfolio.resume << ": no vertex of the graph read" << endl;
+      exit(1);
+    }
+    solver.load(*resumed);
+    publish(solver.solution());
+    cout << "Resumed from an independant set of size " << solver.solution().size() << endl;
+  }
 
-    std::cout << "Dominating set size: "
-              << solver.solution().size()
-              << std::flush;
-    
-    double improved = elapsed();
+  std::mutex output;
 
-    while(elapsed() < maxtime && elapsed() - improved < maxtime / 8) {
-      if(solver.improve()) {
-        // std::cout << " -> " << solver.solution().size() << std::flush;
-        improved = elapsed();
+  portfolio.run([&](int worker) {
+    Generator rng(portfolio.worker_seed(worker));
+    bool resume = !portfolio.resume.empty();
+    auto trace = telemetry.trace(worker);
+
+    for(long restarts = 0; !interrupted && (portfolio.counted() ? restarts < portfolio.restarts : elapsed() < maxtime); restarts++) {
+      long iterations = 0;
+      Solver<Vertex> solver(g, rng());
+
+      auto start = portfolio.from_best || resume ? best.get() : nullptr;
+      resume = false;
+      if(start)
+        solver.load(*start);
+      else
+        solver.solve_greedy();
+
+      {
+        std::lock_guard lock(output);
+        std::cout << "Independant set size: "
+                  << solver.solution().size()
+                  << std::endl;
       }
-      iterations++;
-    }
 
-    if(solution.empty() || solver.solution().size() < solution.size())
-      solution = solver.solution();
-    
-    // std::cout << std::endl
-    //           << "After " << iterations << " iterations,"
-    //           << " we found a dominating set of size "
-    //           << solver.solution().size()
-    //           << " and the best size found is "
-    //           << solution.size()
-    //           << std::endl;
-  }
+      double improved = elapsed();
+      trace.start(improved, solver.solution().size());
+      LazyClock clock; // About one clock read per millisecond, not two per iteration
 
-  string outfn = argv[1]; // Create filename for output
-  outfn.replace(outfn.end()-5, outfn.end(), "ind");
-  save(outfn, solution);
+      // A counted budget never reads the clock, so that the run only depends
+      // on the seed
+      auto going = [&] {
+        if(interrupted)
+          return false;
+        if(portfolio.counted())
+          return iterations < portfolio.iterations;
+        double now = clock.now();
+        return now < maxtime && now - improved < maxtime / 8;
+      };
+
+      while(going()) {
+        if(solver.improve()) {
+          // std::cout << " -> " << solver.solution().size() << std::flush;
+          improved = elapsed();
+          trace.improved(improved, solver.solution().size(), iterations + 1);
+          if(checkpoint.due())
+            publish(solver.solution());
+        }
+        iterations++;
+      }
+
+      trace.end(elapsed(), solver.solution().size(), iterations);
+      publish(solver.solution());
+
+      // std::lock_guard lock(output);
+      // std::cout << "Worker " << worker << ": "
+      //           << "After " << iterations << " iterations,"
+      //           << " we found an independant set of size "
+      //           << solver.solution().size()
+      //           << " and the best size found is "
+      //           << best.get()->size()
+      //           << std::endl;
+    }
+    telemetry.add(std::move(trace));
+  });
+  telemetry.write();
+
+  auto solution = best.get();
+  assert(!solution || conflicts(g, *solution).empty());
+  save(outfn, solution ? *solution : std::vector<int>(), g);
   
   return 0;
 }
@@ -0,0 +1,137 @@
+#ifndef PORTFOLIO_HPP
+#define PORTFOLIO_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <exception>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Best solution found by any worker. Workers publish a copy of their
+// solution and the slot keeps it if it beats the current one, with a
+// compare and swap. The slot is not lock free: libstdc++ guards an atomic
+// shared_ptr with a spinlock, held for a pointer swap and never while a
+// solution is copied. Better compares the sizes of two solutions.
+template<class Better>
+class BestSolution {
+  std::atomic<std::shared_ptr<const std::vector<int>>> slot;
+  Better better;
+
+public:
+  // Returns true when s became the best solution
+  bool offer(const std::vector<int> &s) {
+    auto current = slot.load();
+    if(current && !better(s.size(), current->size()))
+      return false; // No copy when the solution is not better
+    auto mine = std::make_shared<const std::vector<int>>(s);
+    while(!current || better(s.size(), current->size())) {
+      if(slot.compare_exchange_weak(current, mine))
+        return true;
+    }
+    return false;
+  }
+
+  // Null until a solution is offered
+  std::shared_ptr<const std::vector<int>> get() const {
+    return slot.load();
+  }
+};
+
+// Portfolio options, from the arguments after the input file.
+// By default the search stops on the clock, so two runs differ. With
+// --iterations each restart runs that many iterations and each worker
+// --restarts restarts, the clock is never read and a worker only depends on
+// its seed: the run is reproducible as long as --from-best is not set, which
+// reads what the other workers found so far. With several threads the size
+// found is reproducible, but the set saved may be any of the best ones.
+struct Portfolio {
+  int threads = 1;
+  unsigned seed = 1;
+  bool from_best = false; // Restart from the best solution instead of greedy
+  std::string resume;      // Solution file of an earlier run to start from
+  std::string telemetry;   // CSV file for the events of the search
+  long iterations = 0;     // Iterations of each restart, 0 to stop on the clock
+  long restarts = 1;       // Restarts of each worker when iterations is set
+
+  // Seed of worker w, the runs of a worker only depend on it
+  unsigned worker_seed(int w) const {
+    std::seed_seq seq{seed, (unsigned) w};
+    unsigned ret;
+    seq.generate(&ret, &ret + 1);
+    return ret;
+  }
+
+  // Whether the budget is counted in iterations instead of seconds
+  bool counted() const {
+    return iterations > 0;
+  }
+
+  // Returns false on an unknown argument or a malformed number
+  bool parse(int argc, char **argv) {
+    for(int i = 0; i < argc; i++) {
+      std::string arg = argv[i];
+      long long value;
+      auto number = [&](std::size_t prefix) {
+        return parse_number(arg.substr(prefix), value);
+      };
+      if(arg.starts_with("--threads=")) {
+        if(!number(10))
+          return false;
+        threads = std::clamp(value, 1ll, 1ll << 16);
+      }
+      else if(arg.starts_with("--seed=")) {
+        if(!number(7) || value > UINT_MAX)
+          return false;
+        seed = value;
+      }
+      else if(arg.starts_with("--iterations=")) {
+        if(!number(13))
+          return false;
+        iterations = value;
+      }
+      else if(arg.starts_with("--restarts=")) {
+        if(!number(11) || value < 1)
+          return false;
+        restarts = value;
+      }
+      else if(arg == "--from-best")
+        from_best = true;
+      else if(arg.starts_with("--resume="))
+        resume = arg.substr(9);
+      else if(arg.starts_with("--telemetry="))
+        telemetry = arg.substr(12);
+      else
+        return false;
+    }
+    return true;
+  }
+
+  // Reads a non negative number that fills s
+  static bool parse_number(const std::string &s, long long &value) {
+    std::size_t end = 0;
+    try {
+      value = std::stoll(s, &end);
+    }
+    catch(const std::exception &) {
+      return false;
+    }
+    return end == s.size() && value >= 0;
+  }
+
+  // Runs worker(w) for w in 0..threads-1, on its own thread
+  template<class Worker>
+  void run(Worker &&worker) const {
+    std::vector<std::thread> workers;
+    for(int w = 1; w < threads; w++)
+      workers.emplace_back(worker, w);
+    worker(0);
+    for(auto &t : workers)
+      t.join();
+  }
+};
+
+#endif
@@ -4,8 +4,10 @@
 
 #include "graph.hpp"
 #include "tools.hpp"
+#include "checkpoint.hpp"
+#include "../../common/radixsort.hpp"
 #include <iostream>
-#include <unordered_set>
+#include <vector>
 #include <queue>
 #include <cassert>
 #include <random>
@@ -14,45 +16,62 @@
 using Generator = std::mt19937;
 using Distributor = std::uniform_int_distribution<std::size_t>;
 
+// Vertices are the dense ids 0..n-1 of the graph, translated back to the
+// ids of the file only by save
 template <class Vertex>
 class Solver
 {
     mutable Generator rng;
     
     const Graph<Vertex> &g;
-    std::unordered_set<Vertex> independant;
-    std::vector<Vertex> vertices;
-    std::unordered_map<Vertex, int> dependancy;
+    SparseSet independant;
+    // Number of independant vertices in the closed neighborhood of each vertex
+    std::vector<int> dependancy;
+    // Vertices whose dependancy is 0, which can join the independant set
+    SparseSet neighborless;
 
 public:
-    Solver(const Graph<Vertex> &_g):
-        rng(std::random_device{}()),
+    Solver(const Graph<Vertex> &_g, unsigned seed):
+        rng(seed),
         g(_g),
-        independant()
+        independant(g.countVertices()),
+        dependancy(g.countVertices(), 0),
+        neighborless(g.countVertices())
     {
-        {
-            std::unordered_set<Vertex> v = g.vertices();
-            vertices = {v.begin(), v.end()};
-        }
-        
-        for (auto v : vertices) {
-            dependancy[v] = 0;
+        for (int v = 0; v < g.countVertices(); v++)
+            neighborless.insert(v);
+        // A vertex with an edge to itself conflicts with itself, it never
+        // becomes neighborless
+        for (int v : g.loops()) {
+            dependancy[v] = 1;
+            neighborless.erase(v);
         }
     }
 
+    // Takes the vertices by increasing degree, each one that has no
+    // independant neighbor yet
     void solve_greedy()
     {
-        auto queue = vertices;
-            std::sort(queue.begin(), queue.end(),
-                [this](const Vertex& a, const Vertex& b) -> bool {
-                    return g.degree(a) < g.degree(b);
-                });
-        
-        while(!queue.empty()) {
-            Vertex& v = queue.front();
+        std::vector<int> queue(g.countVertices());
+        for (int v = 0; v < (int)queue.size(); v++)
+            queue[v] = v;
+        radixSort(queue, [this](int v) { return g.degree(v); });
+
+        for (int v : queue) {
+            if (!neighborless.contains(v)) continue;
             independant.insert(v);
-            incrementNeighbors(v); // Update the count (or add the neighbor)
-            removeNeighborsFromQueue(queue, v);
+            incrementNeighbors(v);
+        }
+    }
+
+    // Starts from a known independant set instead of the greedy one,
+    // vertices that conflict with earlier ones are skipped
+    void load(const std::vector<int>& ind)
+    {
+        for (int v : ind) {
+            if (!neighborless.contains(v)) continue;
+            independant.insert(v);
+            incrementNeighbors(v);
         }
     }
 
@@ -72,50 +91,38 @@ public:
     }
 
     // Getter for the solution
-    const std::unordered_set<Vertex>& solution()
+    const std::vector<int>& solution()
     {
-        return independant;
+        return independant.elements();
     }
 
 private:
-    void incrementNeighbors(const Vertex& v)
+    void incrementNeighbors(int v)
     {
-        for (Vertex u : g.closedNeighbors(v)) {
-            dependancy[u] += 1;
+        if (dependancy[v]++ == 0)
+            neighborless.erase(v);
+        for (int u : g.neighbors(v)) {
+            if (dependancy[u]++ == 0)
+                neighborless.erase(u);
         }
     }
 
-    void decrementNeighbors(const Vertex& v)
+    void decrementNeighbors(int v)
     {
-        for (Vertex u : g.closedNeighbors(v)) {
-            dependancy[u] -= 1;
+        if (--dependancy[v] == 0)
+            neighborless.insert(v);
+        for (int u : g.neighbors(v)) {
+            if (--dependancy[u] == 0)
+                neighborless.insert(u);
         }
     }
 
-    void removeNeighborsFromQueue(std::vector<Vertex>& list, Vertex& v)
+    std::optional<int> randomNeighborless() const
     {
-        // capture closed by value to avoid binding a reference to a temporary
-        auto closed = g.closedNeighbors(v);
-        list.erase(
-            std::remove_if(list.begin(), list.end(),
-                [closed](const Vertex& n) { return closed.contains(n); }
-            ),
-            list.end()
-        );
-    }
+        if (neighborless.empty()) return {};
 
-    std::optional<Vertex> randomNeighborless() const
-    {
-        std::vector<Vertex> noNeighbors;
-        for (auto [v, ind_degree] : dependancy) 
-            if (ind_degree == 0)
-                noNeighbors.push_back(v);
-        
-        if (noNeighbors.size() == 0) return {};
-
-        Distributor dis(0, noNeighbors.size() - 1);
-        size_t randint = dis(rng);
-        return noNeighbors[randint];
+        Distributor dis(0, neighborless.size() - 1);
+        return neighborless[dis(rng)];
     }
 
     void removeRandomInd()
@@ -123,26 +130,23 @@ private:
         if (independant.empty()) return ;
 
         Distributor dis(0, independant.size() - 1);
+        int v = independant[dis(rng)];
 
-        auto it = independant.begin();
-        std::advance(it, dis(rng));
-        
-        decrementNeighbors(*it);
-
-        independant.erase(it);
+        independant.erase(v);
+        decrementNeighbors(v);
     }
 };
 
-// Save the solution to a file
+// Save the solution to a file, with the vertex ids of the input
 template <class Vertex>
-void save(const std::string &outfn, std::unordered_set<Vertex> solution)
+void save(const std::string &outfn, const std::vector<int> &solution, const Graph<Vertex> &g)
 {
-    std::ofstream outfile(outfn);
-    for (Vertex v : solution)
+    if (!write_solution(outfn, solution, g))
     {
-        outfile << v << std::endl;
+        std::cout << "Could not write " << outfn << std::endl;
+        return;
     }
-    std::cout << "Saved a dominating set of size " << solution.size() << std::endl;
+    std::cout << "Saved an independant set of size " << solution.size() << std::endl;
 }
 
 #endif
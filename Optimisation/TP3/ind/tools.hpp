@@ -2,8 +2,7 @@
 #define TOOLS_HPP
 
 #include <algorithm>
-#include <unordered_set>
-#include <random>
+#include <vector>
 #include <chrono>
 
 static auto beginTime = std::chrono::high_resolution_clock::now();
@@ -15,39 +14,68 @@ inline double elapsed() {
   return dur.count() / 1000.0;
 }
 
-static std::mt19937 rgen(1);
+// elapsed() for hot loops: the clock is only read once every stride calls.
+// The stride doubles while reads come less than a millisecond apart and
+// halves when they come more than 4 apart
+class LazyClock {
+  double last = elapsed();
+  long stride = 1, left = 1;
 
-// Returns a random element from a vector
-template<class T>
-T random_element(const std::vector<T> &v) {
-  std::uniform_int_distribution<> distrib2(0,v.size()-1);
-  return v[distrib2(rgen)];
-}
+public:
+  double now() {
+    if(--left > 0)
+      return last;
+    double t = elapsed();
+    if(t - last < 0.001)
+      stride = std::min(stride * 2, 1l << 20);
+    else if(t - last > 0.004)
+      stride = std::max(stride / 2, 1l);
+    last = t;
+    left = stride;
+    return last;
+  }
+};
 
+// Set of integers in 0..n-1 with O(1) insert, erase and access by
+// position: the elements are packed in a vector and each one knows its
+// position (-1 when absent), erase moves the last element into the hole
+class SparseSet {
+  std::vector<int> items;
+  std::vector<int> position;
 
-// Returns a vectors with all the subsets of s that have size k
-template<class T>
-std::vector<std::vector<T>> combinations(const std::unordered_set<T> &s, int k) {
-  std::vector<std::vector<T>> previous, ret;
-  ret.push_back(std::vector<T>());
-
-  std::vector<T> sv(s.begin(), s.end());
-  std::shuffle(sv.begin(), sv.end(), rgen);
-
-  for(int i = 0; i < k; i++) {
-    previous = ret;
-    ret.clear();
-    for(T k : sv) {
-      for(auto ps : previous) {
-        if(ps.empty() || ps.back() < k) {
-          ps.push_back(k);
-          ret.push_back(ps);
-        }
-      }
-    }
+public:
+  SparseSet(int n = 0) : position(n, -1) {
   }
 
-  return ret;
-}
+  bool contains(int v) const {
+    return position[v] >= 0;
+  }
+
+  bool insert(int v) {
+    if(contains(v))
+      return false;
+    position[v] = items.size();
+    items.push_back(v);
+    return true;
+  }
+
+  bool erase(int v) {
+    if(!contains(v))
+      return false;
+    int k = position[v];
+    items[k] = items.back();
+    position[items[k]] = k;
+    items.pop_back();
+    position[v] = -1;
+    return true;
+  }
+
+  std::size_t size() const { return items.size(); }
+  bool empty() const { return items.empty(); }
+  int operator[](std::size_t k) const { return items[k]; }
+  const std::vector<int> &elements() const { return items; }
+  auto begin() const { return items.begin(); }
+  auto end() const { return items.end(); }
+};
 
 #endif
@@ -0,0 +1,43 @@
+#ifndef VERIFY_HPP
+#define VERIFY_HPP
+
+#include "graph.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Edges of g with both ends in ind, each once with the smaller id first,
+// the loops included. Membership is a bitset, the vertices are checked in
+// parallel slices
+template<class Vertex>
+std::vector<std::pair<int,int>> conflicts(const Graph<Vertex> &g, const std::vector<int> &ind) {
+  int n = g.countVertices();
+  std::vector<uint64_t> in(n / 64 + 1, 0);
+  for(int v : ind)
+    in[v >> 6] |= uint64_t(1) << (v & 63);
+  auto contains = [&](int v) { return in[v >> 6] >> (v & 63) & 1; };
+
+  unsigned threads = std::clamp(n >> 16, 1, (int) std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<std::vector<std::pair<int,int>>> found(threads);
+  parallel(threads, [&](unsigned t, unsigned count) {
+    for(int v = (long long) n * t / count; v < (long long) n * (t + 1) / count; v++) {
+      if(!contains(v))
+        continue;
+      for(int u : g.neighbors(v))
+        if(v < u && contains(u))
+          found[t].emplace_back(v, u);
+    }
+  });
+
+  std::vector<std::pair<int,int>> ret;
+  for(int v : g.loops())
+    if(contains(v))
+      ret.emplace_back(v, v);
+  for(auto &f : found)
+    ret.insert(ret.end(), f.begin(), f.end());
+  return ret;
+}
+
+#endif
@@ -0,0 +1,103 @@
+// BERTOLINI Garice
+#ifndef RADIXSORT_HPP
+#define RADIXSORT_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Sorting utilities shared by the TPs
+
+namespace radix_detail
+{
+    // Maps keys to unsigned integers in the same order
+    template <class K>
+        requires std::is_integral_v<K>
+    uint64_t ordered(K k)
+    {
+        return (uint64_t)(int64_t)k ^ (1ull << 63); // Flip the sign bit
+    }
+
+    inline uint64_t ordered(double d)
+    {
+        uint64_t u = std::bit_cast<uint64_t>(d + 0.0); // -0.0 becomes 0.0
+        return u >> 63 ? ~u : u | (1ull << 63);
+    }
+
+    inline uint64_t ordered(float f)
+    {
+        return ordered((double)f);
+    }
+}
+
+// Stable LSD radix sort of items by keyOf(item), an integer or floating
+// point key computed once per item. 11-bit digits: 6 passes over the
+// 64-bit keys at most, passes where every key has the same digit are skipped.
+// O(n) instead of the O(n log n) comparisons of std::sort, each of which
+// would compute two keys.
+template <class T, class KeyOf>
+void radixSort(std::vector<T> &items, KeyOf &&keyOf)
+{
+    constexpr int bits = 11;
+    constexpr int passes = (64 + bits - 1) / bits;
+    constexpr std::size_t buckets = 1 << bits;
+    const std::size_t n = items.size();
+
+    std::vector<uint64_t> keys(n);
+    for (std::size_t i = 0; i < n; ++i)
+        keys[i] = radix_detail::ordered(keyOf(items[i]));
+
+    if (n < 64) // Not worth the histograms
+    {
+        std::vector<std::size_t> perm(n);
+        for (std::size_t i = 0; i < n; ++i)
+            perm[i] = i;
+        std::stable_sort(perm.begin(), perm.end(), [&](std::size_t a, std::size_t b) {
+            return keys[a] < keys[b];
+        });
+        std::vector<T> sorted;
+        sorted.reserve(n);
+        for (std::size_t a : perm)
+            sorted.push_back(std::move(items[a]));
+        items = std::move(sorted);
+        return;
+    }
+
+    // All the histograms in one read
+    std::vector<std::array<std::size_t, buckets>> count(passes);
+    for (auto &c : count)
+        c.fill(0);
+    for (uint64_t k : keys)
+        for (int p = 0; p < passes; ++p)
+            count[p][(k >> (p * bits)) & (buckets - 1)]++;
+
+    std::vector<uint64_t> keysTmp(n);
+    std::vector<T> itemsTmp(n);
+    for (int p = 0; p < passes; ++p)
+    {
+        auto &c = count[p];
+        if (std::find(c.begin(), c.end(), n) != c.end())
+            continue; // Same digit everywhere
+
+        std::size_t sum = 0;
+        for (auto &b : c)
+            sum += std::exchange(b, sum);
+
+        int shift = p * bits;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::size_t &slot = c[(keys[i] >> shift) & (buckets - 1)];
+            keysTmp[slot] = keys[i];
+            itemsTmp[slot] = std::move(items[i]);
+            ++slot;
+        }
+        keys.swap(keysTmp);
+        items.swap(itemsTmp);
+    }
+}
+
+#endif